@@ -2,15 +2,23 @@
 
 #include "simple_macros.hpp"
 #include "simple_algorithm.hpp"
+#include "simple_allocation_tracker.hpp"
+#include "simple_append_buffer.hpp"
+#include "simple_concurrent_map.hpp"
 #include "simple_dynamic_array.hpp"
+#include "simple_frame_arena.hpp"
+#include "simple_pool_allocator.hpp"
+#include "simple_small_dynamic_array.hpp"
 #include "simple_window.hpp"
 #include "simple_logging.hpp"
 #include "simple_array.hpp"
 #include "simple_set.hpp"
+#include "simple_slot_map.hpp"
 #include "simple_map.hpp"
 #include "simple_UID.hpp"
 #include "simple_field.hpp"
 #include "simple_vulkan.hpp"
+#include "simple_vulkan_allocator.hpp"
 #include <assert.h>
 #include <thread>
 #include <mutex>
@@ -167,84 +175,70 @@ namespace simple {
 	class RenderingContext {
 	public:
 
+		typedef SlotHandle MeshHandle;
+		typedef SlotHandle ShaderObjectHandle;
+		typedef SlotHandle PipelineHandle;
+
+		template<typename T>
+		using ContextAllocator = TrackingAllocator<T, allocation_tags::RenderingContext>;
+
 		struct Mesh {
 
-			Mesh** reference;
-			uint64_t UID;
-			uint32_t vertexVkBufferCount;
-			VkBuffer* vertexVkBuffers;
-			VkDeviceSize* vertexBufferOffsets;
+			static constexpr inline uint32_t inline_vertex_buffer_count = 4;
+
+			SmallDynamicArray<VkBuffer, inline_vertex_buffer_count> vertexVkBuffers;
+			SmallDynamicArray<VkDeviceSize, inline_vertex_buffer_count> vertexBufferOffsets;
 			VkBuffer indexVkBuffer;
 
-			inline Mesh(Mesh** reference, uint64_t UID, uint32_t vertexVkBufferCount, VkBuffer* vertexVkBuffers, VkDeviceSize* vertexBufferOffsets, VkBuffer indexVkBuffer) noexcept
-				: reference(reference), UID(UID), vertexVkBufferCount(vertexVkBufferCount), vertexVkBuffers(vertexVkBuffers), 
-					vertexBufferOffsets(vertexBufferOffsets), indexVkBuffer(indexVkBuffer) {}
+			inline Mesh(uint32_t vertexVkBufferCount, VkBuffer* vertexVkBuffers, VkDeviceSize* vertexBufferOffsets, VkBuffer indexVkBuffer) noexcept
+				: vertexVkBuffers(vertexVkBuffers, vertexVkBuffers + vertexVkBufferCount), 
+					vertexBufferOffsets(vertexBufferOffsets, vertexBufferOffsets + vertexVkBufferCount), indexVkBuffer(indexVkBuffer) {}
 
 			inline Mesh(Mesh&& other) noexcept
-				: reference(other.reference), UID(other.UID), vertexVkBufferCount(other.vertexVkBufferCount), vertexVkBuffers(other.vertexVkBuffers),
+				: vertexVkBuffers(std::move(other.vertexVkBuffers)), vertexBufferOffsets(std::move(other.vertexBufferOffsets)), 
 					indexVkBuffer(other.indexVkBuffer) {
-				other.reference = nullptr;
-				other.UID = 0;
-				other.vertexVkBufferCount = 0;
-				other.vertexVkBuffers = VK_NULL_HANDLE;
-				indexVkBuffer = VK_NULL_HANDLE;
-				*reference = this;
-			}
-
-			constexpr inline bool operator==(const Mesh& other) const {
-				return UID == other.UID;
+				other.indexVkBuffer = VK_NULL_HANDLE;
 			}
 		};
 
 		struct ShaderObject {
 
-			inline ShaderObject(ShaderObject** reference, uint64_t UID, uint32_t vkDescriptorSetCount, VkDescriptorSet* vkDescriptorSets) noexcept 
-				: _reference(reference), _UID(UID), _vkDescriptorSetCount(vkDescriptorSetCount), _vkDescriptorSets(vkDescriptorSets), _meshUIDState(UID::GenerateState64()) {}
+			inline ShaderObject(uint32_t vkDescriptorSetCount, VkDescriptorSet* vkDescriptorSets) noexcept 
+				: _vkDescriptorSetCount(vkDescriptorSetCount), _vkDescriptorSets(vkDescriptorSets) {}
 			
 			inline ShaderObject(ShaderObject&& other) noexcept 
-				: _reference(other._reference), _UID(other._UID), _vkDescriptorSetCount(other._vkDescriptorSetCount), _vkDescriptorSets(other._vkDescriptorSets),
-					_meshUIDState() {
+				: _vkDescriptorSetCount(other._vkDescriptorSetCount), _vkDescriptorSets(other._vkDescriptorSets) {
 				LockGuard lockGuard(other._meshesMutex);
-				_meshUIDState = other._meshUIDState.load();
-				new(&_meshes) DynamicArray<Mesh>(std::move(other._meshes));
-				*_reference = this;
-				other._reference = nullptr;
-				other._UID = 0;
+				new(&_meshes) SlotMap<Mesh, ContextAllocator<Mesh>>(std::move(other._meshes));
 			}
 
 			template<uint32_t T_vertex_buffer_count>
-			inline const Mesh* AddMesh(Mesh** meshReference, VkBuffer vertexBuffers[T_vertex_buffer_count], VkDeviceSize vertexBufferOffsets[T_vertex_buffer_count], VkBuffer indexBuffer) noexcept {
+			inline MeshHandle AddMesh(VkBuffer vertexBuffers[T_vertex_buffer_count], VkDeviceSize vertexBufferOffsets[T_vertex_buffer_count], VkBuffer indexBuffer) noexcept {
 				LockGuard lockGuard(_meshesMutex);
-				return &_meshes.EmplaceBack(meshReference, UID::Shuffle(_meshUIDState), T_vertex_buffer_count, vertexBuffers, vertexBufferOffsets, indexBuffer);
+				return _meshes.Emplace(T_vertex_buffer_count, vertexBuffers, vertexBufferOffsets, indexBuffer);
 			}
 
-			inline bool RemoveMesh(const Mesh& mesh) {
+			inline bool RemoveMesh(MeshHandle mesh) {
 				LockGuard lockGuard(_meshesMutex);
-				auto iter = _meshes.Find(mesh);
-				if (iter == _meshes.end()) {
-					logError(this, "failed to remove mesh (function simple::RenderingContext::ShaderObject::RemoveMesh), may indicate invalid simple::RenderingContext::Mesh handle");
+				if (!_meshes.Erase(mesh)) {
+					logError(this, "failed to remove mesh (function simple::RenderingContext::ShaderObject::RemoveMesh), may indicate invalid simple::RenderingContext::MeshHandle");
 					return false;
 				}
-				_meshes.Erase(iter);
 				return true;
 			}
 
-			struct Hash {
-				inline uint64_t operator()(const ShaderObject& shaderObject) {
-					return shaderObject._UID;
-				}
-			};
+			inline bool ContainsMesh(MeshHandle mesh) {
+				LockGuard lockGuard(_meshesMutex);
+				return _meshes.Contains(mesh);
+			}
 
 		private:
 
-			ShaderObject** _reference;
 			VkClearValue clearValue{};
-			uint64_t _UID;
 			uint32_t _vkDescriptorSetCount;
 			VkDescriptorSet* _vkDescriptorSets;
-			DynamicArray<Mesh> _meshes{};
+			SlotMap<Mesh, ContextAllocator<Mesh>> _meshes{};
 			Mutex _meshesMutex{};
-			std::atomic<uint64_t> _meshUIDState;
 
 			friend class Backend;
 		};
@@ -252,40 +246,43 @@ namespace simple {
 		struct Pipeline {
 		public:	
 
-			inline Pipeline(Pipeline** reference, uint64_t UID, VkPipeline vkPipeline, VkPipelineLayout vkPipelineLayout) noexcept
-				: _reference(reference), _UID(UID), _vkPipeline(vkPipeline), _vkPipelineLayout(vkPipelineLayout), _shaderObjectsUIDState(UID::GenerateState64()) {}
+			inline Pipeline(VkPipeline vkPipeline, VkPipelineLayout vkPipelineLayout) noexcept
+				: _vkPipeline(vkPipeline), _vkPipelineLayout(vkPipelineLayout) {}
 
 			inline Pipeline(Pipeline&& other) noexcept 
-				: _reference(other._reference), _UID(other._UID), _vkPipeline(other._vkPipeline), _vkPipelineLayout(other._vkPipelineLayout),
-					_shaderObjectsUIDState() {
+				: _vkPipeline(other._vkPipeline), _vkPipelineLayout(other._vkPipelineLayout) {
 				LockGuard lockGuard(other._shaderObjectsMutex);
-				_shaderObjectsUIDState = other._shaderObjectsUIDState.load();
-				new(&_shaderObjects) DynamicArray<ShaderObject>(std::move(other._shaderObjects));
-				*_reference = this;
-				other._reference = nullptr;
-				other._UID = 0;
+				new(&_shaderObjects) SlotMap<ShaderObject, ContextAllocator<ShaderObject>>(std::move(other._shaderObjects));
 			}
 
 			template<uint32_t T_descriptor_set_count>
-			inline const ShaderObject* AddShaderObject(ShaderObject** shaderObjectReference, VkDescriptorSet vkDescriptorSets[T_descriptor_set_count]) {
+			inline ShaderObjectHandle AddShaderObject(VkDescriptorSet vkDescriptorSets[T_descriptor_set_count]) {
 				LockGuard lockGuard(_shaderObjectsMutex);
-				return *_shaderObjects.EmplaceBack(shaderObjectReference, UID::Shuffle(_shaderObjectsUIDState), T_descriptor_set_count, vkDescriptorSets);
+				return _shaderObjects.Emplace(T_descriptor_set_count, vkDescriptorSets);
 			}
 
-			constexpr inline bool operator==(const Pipeline& other) const {
-				return _UID == other._UID;
+			inline bool RemoveShaderObject(ShaderObjectHandle shaderObject) {
+				LockGuard lockGuard(_shaderObjectsMutex);
+				if (!_shaderObjects.Erase(shaderObject)) {
+					logError(this, "failed to remove shader object (function simple::RenderingContext::Pipeline::RemoveShaderObject), may indicate invalid simple::RenderingContext::ShaderObjectHandle");
+					return false;
+				}
+				return true;
+			}
+
+			// the pointer is only valid until the next shader object is added to or removed from this pipeline
+			inline ShaderObject* GetShaderObject(ShaderObjectHandle shaderObject) {
+				LockGuard lockGuard(_shaderObjectsMutex);
+				return _shaderObjects.Find(shaderObject);
 			}
 
 		private:
 
-			Pipeline** _reference;
-			uint64_t _UID;
 			VkPipeline _vkPipeline;
 			VkPipelineLayout _vkPipelineLayout;
 
-			DynamicArray<ShaderObject> _shaderObjects{};
+			SlotMap<ShaderObject, ContextAllocator<ShaderObject>> _shaderObjects{};
 			Mutex _shaderObjectsMutex{};
-			std::atomic<uint64_t> _shaderObjectsUIDState;
 
 			friend class Backend;
 		};
@@ -295,13 +292,12 @@ namespace simple {
 		RenderArea _renderArea{};
 		uint32_t _colorAttachmentCount{};
 		RenderingAttachment* _pColorAttachments{};
-		DynamicArray<VkRenderingAttachmentInfo> _vkColorAttachments{};
+		SmallDynamicArray<VkRenderingAttachmentInfo, 4, ContextAllocator<VkRenderingAttachmentInfo>> _vkColorAttachments{};
 		RenderingAttachment* _pDepthAttachment{};
 		RenderingAttachment* _pStencilAttachment{};
 
-		DynamicArray<Pipeline> _pipelines{};
+		SlotMap<Pipeline, ContextAllocator<Pipeline>> _pipelines{};
 		Mutex _pipelinesMutex{};
-		std::atomic<uint64_t> _pipelinesUIDState;
 
 	public:
 
@@ -315,22 +311,26 @@ namespace simple {
 			_pStencilAttachment = pStencilAttachment;
 		}
 
-		inline const Pipeline* AddPipeline(Pipeline** pipelineReference, VkPipeline vkPipeline, VkPipelineLayout vkPipelineLayout) {
+		inline PipelineHandle AddPipeline(VkPipeline vkPipeline, VkPipelineLayout vkPipelineLayout) {
 			LockGuard lockGuard(_pipelinesMutex);
-			return &_pipelines.EmplaceBack(pipelineReference, UID::Shuffle(_pipelinesUIDState), vkPipeline, vkPipelineLayout);
+			return _pipelines.Emplace(vkPipeline, vkPipelineLayout);
 		}
 
-		inline bool RemovePipeline(const Pipeline& pipeline) noexcept {
+		inline bool RemovePipeline(PipelineHandle pipeline) noexcept {
 			LockGuard lockGuard(_pipelinesMutex);
-			auto iter = _pipelines.Find(pipeline);
-			if (iter == _pipelines.end()) {
-				logError(this, "failed to remove mesh (function simple::RenderingContext::ShaderObject::RemoveMesh), may indicate invalid simple::RenderingContext::Mesh handle");
+			if (!_pipelines.Erase(pipeline)) {
+				logError(this, "failed to remove pipeline (function simple::RenderingContext::RemovePipeline), may indicate invalid simple::RenderingContext::PipelineHandle");
 				return false;
 			}
-			_pipelines.Erase(iter);
 			return true;
 		}
 
+		// the pointer is only valid until the next pipeline is added to or removed from this rendering context
+		inline Pipeline* GetPipeline(PipelineHandle pipeline) {
+			LockGuard lockGuard(_pipelinesMutex);
+			return _pipelines.Find(pipeline);
+		}
+
 		inline void SetRenderArea(const RenderArea& renderArea) noexcept {
 			_renderArea = renderArea;
 		}
@@ -365,12 +365,19 @@ namespace simple {
 			if (threadID == _mainThread._ID) {
 				return &_mainThread;
 			}
-			LockGuard lockGuard(_threadsMutex);
-			auto pair = _threads.Find(threadID);
-			if (pair) {
-				return &pair->second;
+			// threads are never removed before the backend terminates, so a hit can be cached for the lifetime of the thread,
+			// keyed by generation rather than address since a new backend may be constructed where a destroyed one was
+			thread_local uint64_t cachedGeneration = 0;
+			thread_local const Thread* cachedThread = nullptr;
+			if (cachedGeneration == _generation) {
+				return cachedThread;
 			}
-			return nullptr;
+			const Thread* thread = _threads.Find(threadID);
+			if (thread) {
+				cachedGeneration = _generation;
+				cachedThread = thread;
+			}
+			return thread;
 		}
 
 		constexpr inline ImageExtent GetSwapchainImageExtent() const {
@@ -411,7 +418,6 @@ namespace simple {
 		}
 
 		inline bool ThreadExists(std::thread& thread) {
-			LockGuard lockGuard(_threadsMutex);
 			return _threads.Contains(thread.get_id());
 		}
 
@@ -423,15 +429,32 @@ namespace simple {
 			return CommandBuffer(*this, ThreadCommandPool::Graphics, thread._vkGraphicsCommandPool);
 		}
 
+		// memory allocated from the arena (e.g. with simple::FrameAllocator) is valid until the same frame in flight is rendered again
+		inline FrameArena& GetFrameArena() noexcept {
+			return _frameArena;
+		}
+
+		inline const FrameArena& GetFrameArena() const noexcept {
+			return _frameArena;
+		}
+
+		// host memory the vulkan implementation allocated through the engine, per VkSystemAllocationScope
+		inline vulkan::HostAllocator::ScopeStats GetVulkanHostStats(VkSystemAllocationScope scope) const noexcept {
+			return _vkHostAllocator.GetStats(scope);
+		}
+
 	private:
 
+		static inline std::atomic<uint64_t> _lastGeneration{};
+
 		Simple& _engine;
-		VkAllocationCallbacks* _vkAllocationCallbacks = VK_NULL_HANDLE;
-		Map<Thread::ID, Thread, Thread::Hash> _threads{};
-		Mutex _threadsMutex{};
+		// unique per backend for the lifetime of the process, never 0
+		const uint64_t _generation = _lastGeneration.fetch_add(1, std::memory_order_relaxed) + 1;
+		vulkan::HostAllocator _vkHostAllocator{};
+		const VkAllocationCallbacks* _vkAllocationCallbacks = _vkHostAllocator.GetCallbacks();
+		ConcurrentMap<Thread::ID, Thread, Thread::Hash, 16, TrackingAllocator<Thread, allocation_tags::Threads, PoolAllocator<Thread>>> _threads{};
 		Thread _mainThread{};
-		DynamicArray<VkCommandBuffer> _queuedGraphicsCommandBuffers{};
-		Mutex _queuedGraphicsCommandBuffersMutex{};
+		AppendBuffer<VkCommandBuffer> _queuedGraphicsCommandBuffers{};
 		VkInstance _vkInstance{};
 		VkPhysicalDevice _vkPhysicalDevice{};
 		vulkan::PhysicalDeviceInfo _vulkanPhysicalDeviceInfo;
@@ -463,12 +486,11 @@ namespace simple {
 		DynamicArray<Pair<SwapchainRecreateCallback, Field<void*>::Reference>> _swapchainRecreateCallbacks{};
 		Mutex _swapchainRecreateCallbacksMutex{};
 
+		FrameArena _frameArena{ FramesInFlight };
 		uint32_t _currentRenderFrame{};
 
 		inline Thread* _NewThread(std::thread&& thread) {
 
-			LockGuard lockGuard(_threadsMutex);
-
 			Thread::ID threadID = thread.get_id();
 
 			assert(!_threads.Contains(threadID) && "attempting to create simple::Thread when the thread already exists!");
@@ -491,17 +513,18 @@ namespace simple {
 			};
 			assert(Succeeded(vkCreateCommandPool(_vkDevice, &transformCommandPoolInfo, _vkAllocationCallbacks, &newThread._vkTransferCommandPool))&& "failed to create vulkan transfer command pool for simple::Thread");
 
-			return new(_threads[threadID]) Thread(std::move(newThread));
+			return _threads.Emplace(threadID, std::move(newThread)).second;
 		}
 
 		inline void _QueueGraphicsCommandBuffer(VkCommandBuffer commandBuffer) {
-			LockGuard lockGuard(_queuedGraphicsCommandBuffersMutex);
-			_queuedGraphicsCommandBuffers.PushBack(commandBuffer);
+			_queuedGraphicsCommandBuffers.Push(commandBuffer);
 		}
 
-		inline simple::DynamicArray<VkCommandBuffer>&& _MoveGraphicsCommandBuffers() {
-			LockGuard lockGuard(_queuedGraphicsCommandBuffersMutex);
-			return std::move(_queuedGraphicsCommandBuffers);
+		// only called from the render thread, the returned array lives in the current frame's arena region
+		inline DynamicArray<VkCommandBuffer, FrameAllocator<VkCommandBuffer>> _DrainGraphicsCommandBuffers() {
+			DynamicArray<VkCommandBuffer, FrameAllocator<VkCommandBuffer>> commandBuffers(FrameAllocator<VkCommandBuffer>{ _frameArena });
+			_queuedGraphicsCommandBuffers.Drain(commandBuffers);
+			return commandBuffers;
 		}
 
 		void _CreateSwapchain();
@@ -629,7 +652,7 @@ namespace simple {
 						vkCmdBindDescriptorSets(renderCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline._vkPipelineLayout,
 							0, shaderObject._vkDescriptorSetCount, shaderObject._vkDescriptorSets, 0, nullptr);
 						for (RenderingContext::Mesh& mesh : shaderObject._meshes) {
-							vkCmdBindVertexBuffers(renderCommandBuffer, 0, mesh.vertexVkBufferCount, mesh.vertexVkBuffers, mesh.vertexBufferOffsets);
+							vkCmdBindVertexBuffers(renderCommandBuffer, 0, mesh.vertexVkBuffers.Size(), mesh.vertexVkBuffers.Data(), mesh.vertexBufferOffsets.Data());
 							vkCmdBindIndexBuffer(renderCommandBuffer, mesh.indexVkBuffer, 0, VK_INDEX_TYPE_UINT32);
 						}
 					}
@@ -670,6 +693,8 @@ namespace simple {
 				return;
 			}
 			vkWaitForFences(_vkDevice, 1, &_inFlightVkFences[_currentRenderFrame], VK_TRUE, UINT64_MAX);
+			// the gpu is done with everything allocated the last time this frame was rendered
+			_frameArena.BeginFrame(_currentRenderFrame);
 			uint32_t imageIndex;
 			VkResult result = vkAcquireNextImageKHR(_vkDevice, _vkSwapchainKHR, UINT64_MAX, _frameReadyVkSemaphores[_currentRenderFrame], nullptr, &imageIndex);
 			if (result == VK_ERROR_OUT_OF_DATE_KHR) {
@@ -685,7 +710,7 @@ namespace simple {
 			vkResetCommandBuffer(_renderingVkCommandBuffers[_currentRenderFrame], 0);
 			_RenderCmds();
 	
-			simple::DynamicArray<VkCommandBuffer> graphicsCommandBuffers(std::move(_MoveGraphicsCommandBuffers()));
+			DynamicArray<VkCommandBuffer, FrameAllocator<VkCommandBuffer>> graphicsCommandBuffers = _DrainGraphicsCommandBuffers();
 
 			VkSubmitInfo graphicsVkSubmitInfo {
 				.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
@@ -745,14 +770,13 @@ namespace simple {
 
 		inline void _Terminate() {
 			vkDeviceWaitIdle(_vkDevice);
-			LockGuard lockGuard(_threadsMutex);
 			vkDestroyCommandPool(_vkDevice, _mainThread._vkGraphicsCommandPool, _vkAllocationCallbacks);
 			vkDestroyCommandPool(_vkDevice, _mainThread._vkTransferCommandPool, _vkAllocationCallbacks);
-			for (auto& pair : _threads) {
-				pair.second._stdThread.join();
-				vkDestroyCommandPool(_vkDevice, pair.second._vkGraphicsCommandPool, _vkAllocationCallbacks);
-				vkDestroyCommandPool(_vkDevice, pair.second._vkTransferCommandPool, _vkAllocationCallbacks);
-			}
+			_threads.ForEach([this](const Thread::ID&, Thread& thread) {
+				thread._stdThread.join();
+				vkDestroyCommandPool(_vkDevice, thread._vkGraphicsCommandPool, _vkAllocationCallbacks);
+				vkDestroyCommandPool(_vkDevice, thread._vkTransferCommandPool, _vkAllocationCallbacks);
+			});
 			vkDeviceWaitIdle(_vkDevice);
 			for (size_t i = 0; i < FramesInFlight; i++) {
 				vkDestroySemaphore(_vkDevice, _frameReadyVkSemaphores[i], _vkAllocationCallbacks);
@@ -762,6 +786,8 @@ namespace simple {
 			}
 			vkDestroySwapchainKHR(_vkDevice, _vkSwapchainKHR, _vkAllocationCallbacks);
 			vkDestroyDevice(_vkDevice, _vkAllocationCallbacks);
+			vkDestroySurfaceKHR(_vkInstance, _vkSurfaceKHR, _vkAllocationCallbacks);
+			vkDestroyInstance(_vkInstance, _vkAllocationCallbacks);
 		}
 
 		friend class Simple;
@@ -824,6 +850,7 @@ namespace simple {
 
 		inline void Render() {
 			_backend._Render();
+			AllocationTracker::MergeFrame();
 		}
 
 		~Simple();
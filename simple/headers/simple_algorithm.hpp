@@ -1,6 +1,8 @@
 #pragma once
 
 #include "cstdint"
+#include "simple_simd.hpp"
+#include <type_traits>
 
 namespace simple {
 
@@ -40,8 +42,15 @@ namespace simple {
 		return t0 < t1 ? t1 : t0;
 	}
 
+	// searches arrays of integral types (including chars) with simple::simd::FindValue
 	template<typename T, typename Iter, typename ConstIter>
 	inline Iter Find(const T& val, Iter first, ConstIter end) {
+		if constexpr (std::is_pointer_v<Iter> && std::is_pointer_v<ConstIter> && std::is_integral_v<T>
+			&& std::is_same_v<std::remove_cv_t<std::remove_pointer_t<Iter>>, T>) {
+			size_t count = end - first;
+			size_t index = simd::FindValue<T>(first, count, val);
+			return index == simd::npos ? first + count : first + index;
+		}
 		for (; first != end;) {
 			if (val == *first) {
 				break;
@@ -0,0 +1,356 @@
+#pragma once
+
+#include "simple_allocator.hpp"
+#include "simple_logging.hpp"
+#include <assert.h>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <new>
+#include <utility>
+
+namespace simple {
+
+	// Per tag allocation statistics, collected by simple::TrackingAllocator when SIMPLE_TRACK_ALLOCATIONS is defined.
+	// A tag is any type with a static name, e.g. struct StringTag { static constexpr inline const char* name = "String"; };
+	// Allocating threads only bump counters of their own (single writer, no read-modify-write), the counters of all threads
+	// are merged once per frame by MergeFrame (called by simple::Simple::Render), which is also when live and peak bytes are
+	// measured, so the peak doesn't see spikes within one frame. Without SIMPLE_TRACK_ALLOCATIONS every function is a no-op.
+	class AllocationTracker {
+	public:
+
+		static constexpr inline uint32_t max_tag_count = 64;
+		// tags registered after the table is full are counted under this name
+		static constexpr inline const char* overflow_tag_name = "Other";
+
+		struct TagStats {
+			const char* name;
+			uint64_t allocationCount;
+			uint64_t allocatedBytes;
+			uint64_t liveBytes;
+			uint64_t peakLiveBytes;
+			// during the last merged frame
+			uint64_t frameAllocationCount;
+			uint64_t frameAllocatedBytes;
+		};
+
+		AllocationTracker() = delete;
+
+#ifdef SIMPLE_TRACK_ALLOCATIONS
+
+		template<typename Tag>
+		static inline uint32_t TagId() {
+			static const uint32_t id = _RegisterTag(Tag::name);
+			return id;
+		}
+
+		static inline void RecordAllocation(uint32_t tag, size_t bytes) noexcept {
+			ThreadCounters& counters = _Counters();
+			_Add(counters.allocationCount[tag], 1);
+			_Add(counters.allocatedBytes[tag], bytes);
+		}
+
+		static inline void RecordDeallocation(uint32_t tag, size_t bytes) noexcept {
+			_Add(_Counters().freedBytes[tag], bytes);
+		}
+
+		// sums the counters of every thread into the stats returned by GetStats, call once per frame
+		static inline void MergeFrame() {
+			std::lock_guard lock(_mutex);
+			for (uint32_t tag = 0; tag < _tagCount; tag++) {
+				uint64_t allocationCount = _retired.allocationCount[tag].load(std::memory_order_relaxed);
+				uint64_t allocatedBytes = _retired.allocatedBytes[tag].load(std::memory_order_relaxed);
+				uint64_t freedBytes = _retired.freedBytes[tag].load(std::memory_order_relaxed);
+				for (ThreadCounters* counters = _threads; counters; counters = counters->next) {
+					allocationCount += counters->allocationCount[tag].load(std::memory_order_relaxed);
+					allocatedBytes += counters->allocatedBytes[tag].load(std::memory_order_relaxed);
+					freedBytes += counters->freedBytes[tag].load(std::memory_order_relaxed);
+				}
+				TagStats& stats = _stats[tag];
+				stats.frameAllocationCount = allocationCount - stats.allocationCount;
+				stats.frameAllocatedBytes = allocatedBytes - stats.allocatedBytes;
+				stats.allocationCount = allocationCount;
+				stats.allocatedBytes = allocatedBytes;
+				// counters of different threads are read at slightly different times, so frees may briefly outrun allocations
+				stats.liveBytes = allocatedBytes > freedBytes ? allocatedBytes - freedBytes : 0;
+				stats.peakLiveBytes = stats.liveBytes > stats.peakLiveBytes ? stats.liveBytes : stats.peakLiveBytes;
+			}
+		}
+
+		static inline uint32_t TagCount() {
+			std::lock_guard lock(_mutex);
+			return _tagCount;
+		}
+
+		// stats as of the last MergeFrame
+		static inline TagStats GetStats(uint32_t tag) {
+			std::lock_guard lock(_mutex);
+			assert(tag < _tagCount && "invalid allocation tag (function simple::AllocationTracker::GetStats)!");
+			return _stats[tag];
+		}
+
+		template<typename Tag>
+		static inline TagStats GetStats() {
+			return GetStats(TagId<Tag>());
+		}
+
+		// calls func with the TagStats of every registered tag
+		template<typename Func>
+		static inline void ForEach(Func&& func) {
+			std::lock_guard lock(_mutex);
+			for (uint32_t tag = 0; tag < _tagCount; tag++) {
+				func(static_cast<const TagStats&>(_stats[tag]));
+			}
+		}
+
+		// writes the stats of the last MergeFrame as a table to the file at path, returns false if the file can't be written
+		static inline bool DumpReport(const char* path) {
+			std::FILE* file = std::fopen(path, "w");
+			if (!file) {
+				logError(nullptr, "failed to open allocation report file (function simple::AllocationTracker::DumpReport)!");
+				return false;
+			}
+			std::fprintf(file, "%-32s %14s %16s %16s %16s %14s %16s\n",
+				"tag", "allocations", "allocated bytes", "live bytes", "peak live bytes", "frame allocs", "frame bytes");
+			ForEach([file](const TagStats& stats) {
+				std::fprintf(file, "%-32s %14llu %16llu %16llu %16llu %14llu %16llu\n", stats.name,
+					(unsigned long long)stats.allocationCount, (unsigned long long)stats.allocatedBytes,
+					(unsigned long long)stats.liveBytes, (unsigned long long)stats.peakLiveBytes,
+					(unsigned long long)stats.frameAllocationCount, (unsigned long long)stats.frameAllocatedBytes);
+			});
+			bool written = !std::ferror(file);
+			written &= !std::fclose(file);
+			if (!written) {
+				logError(nullptr, "failed to write allocation report (function simple::AllocationTracker::DumpReport)!");
+			}
+			return written;
+		}
+
+	private:
+
+		// zero initialized, by value initialization or as a static
+		struct ThreadCounters {
+			std::atomic<uint64_t> allocationCount[max_tag_count];
+			std::atomic<uint64_t> allocatedBytes[max_tag_count];
+			std::atomic<uint64_t> freedBytes[max_tag_count];
+			ThreadCounters* next;
+		};
+
+		// moves the counters of an exiting thread into _retired
+		struct Releaser {
+			bool registered;
+
+			inline ~Releaser() {
+				ThreadCounters* counters = _threadCounters;
+				if (!counters) {
+					return;
+				}
+				_threadCounters = nullptr;
+				std::lock_guard lock(_mutex);
+				for (ThreadCounters** link = &_threads; *link; link = &(*link)->next) {
+					if (*link == counters) {
+						*link = counters->next;
+						break;
+					}
+				}
+				for (uint32_t tag = 0; tag < max_tag_count; tag++) {
+					_Add(_retired.allocationCount[tag], counters->allocationCount[tag].load(std::memory_order_relaxed));
+					_Add(_retired.allocatedBytes[tag], counters->allocatedBytes[tag].load(std::memory_order_relaxed));
+					_Add(_retired.freedBytes[tag], counters->freedBytes[tag].load(std::memory_order_relaxed));
+				}
+				delete counters;
+			}
+		};
+
+		// only the owning thread writes, so a plain load and store is enough for the merging thread to see whole values
+		static inline void _Add(std::atomic<uint64_t>& counter, uint64_t value) noexcept {
+			counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+		}
+
+		static inline ThreadCounters& _Counters() {
+			ThreadCounters* counters = _threadCounters;
+			if (!counters) {
+				counters = _RegisterThread();
+			}
+			return *counters;
+		}
+
+		static inline ThreadCounters* _RegisterThread() {
+			ThreadCounters* counters = new ThreadCounters();
+			{
+				std::lock_guard lock(_mutex);
+				counters->next = _threads;
+				_threads = counters;
+			}
+			_threadCounters = counters;
+			// first use of the releaser on this thread registers its destructor
+			_releaser.registered = true;
+			return counters;
+		}
+
+		static inline uint32_t _RegisterTag(const char* name) {
+			std::lock_guard lock(_mutex);
+			if (_tagCount >= max_tag_count - 1) {
+				if (_tagCount == max_tag_count - 1) {
+					logWarning(nullptr, "too many allocation tags, further tags are counted as \"Other\" (warning from simple::AllocationTracker::TagId)!");
+					_stats[_tagCount].name = overflow_tag_name;
+					_tagCount = max_tag_count;
+				}
+				return max_tag_count - 1;
+			}
+			_stats[_tagCount].name = name;
+			return _tagCount++;
+		}
+
+		static inline std::mutex _mutex{};
+		static inline uint32_t _tagCount = 0;
+		static inline TagStats _stats[max_tag_count]{};
+		static inline ThreadCounters* _threads = nullptr;
+		// counters of threads that have exited
+		static inline ThreadCounters _retired;
+		static inline thread_local ThreadCounters* _threadCounters = nullptr;
+		static inline thread_local Releaser _releaser;
+
+#else
+
+		template<typename Tag>
+		static constexpr inline uint32_t TagId() noexcept {
+			return 0;
+		}
+
+		static constexpr inline void RecordAllocation(uint32_t, size_t) noexcept {}
+
+		static constexpr inline void RecordDeallocation(uint32_t, size_t) noexcept {}
+
+		static constexpr inline void MergeFrame() noexcept {}
+
+		static constexpr inline uint32_t TagCount() noexcept {
+			return 0;
+		}
+
+		template<typename Func>
+		static constexpr inline void ForEach(Func&&) noexcept {}
+
+		static inline bool DumpReport(const char*) noexcept {
+			logWarning(nullptr, "allocation tracking is disabled, define SIMPLE_TRACK_ALLOCATIONS to enable it (warning from simple::AllocationTracker::DumpReport)!");
+			return false;
+		}
+
+#endif
+	};
+
+#ifdef SIMPLE_TRACK_ALLOCATIONS
+
+	// Forwards to Inner and counts every allocation under Tag, see simple::AllocationTracker.
+	// Without SIMPLE_TRACK_ALLOCATIONS this is an alias of Inner.
+	template<typename T, typename Tag, typename Inner = DynamicAllocator<T>>
+	class TrackingAllocator {
+	public:
+
+		using propagate_on_container_copy_assignment = std::bool_constant<AllocatorTraits<Inner>::propagate_on_copy>;
+		using propagate_on_container_move_assignment = std::bool_constant<AllocatorTraits<Inner>::propagate_on_move>;
+		using propagate_on_container_swap = std::bool_constant<AllocatorTraits<Inner>::propagate_on_swap>;
+		using is_always_equal = std::bool_constant<AllocatorTraits<Inner>::always_equal>;
+
+		// keeps the tag and rebinds the inner allocator along
+		template<typename U>
+		struct rebind {
+			using other = TrackingAllocator<U, Tag, typename AllocatorTraits<Inner>::template Rebind<U>>;
+		};
+
+		inline TrackingAllocator() = default;
+
+		inline TrackingAllocator(const Inner& inner) noexcept : _inner(inner) {}
+
+		template<typename U, typename InnerU>
+		inline TrackingAllocator(const TrackingAllocator<U, Tag, InnerU>& other) noexcept : _inner(other.GetInner()) {}
+
+		inline TrackingAllocator select_on_container_copy_construction() const {
+			return TrackingAllocator(AllocatorTraits<Inner>::SelectOnCopy(_inner));
+		}
+
+		inline T* allocate(size_t size) {
+			T* ptr = _inner.allocate(size);
+			if (ptr) {
+				AllocationTracker::RecordAllocation(_Tag(), size * sizeof(T));
+			}
+			return ptr;
+		}
+
+		inline T* reallocate(T* ptr, size_t oldSize, size_t newSize) requires ReallocatingAllocator<Inner, T> {
+			T* result = _inner.reallocate(ptr, oldSize, newSize);
+			if (result) {
+				if (ptr) {
+					AllocationTracker::RecordDeallocation(_Tag(), oldSize * sizeof(T));
+				}
+				AllocationTracker::RecordAllocation(_Tag(), newSize * sizeof(T));
+			}
+			return result;
+		}
+
+		inline void deallocate(T* ptr, size_t size) noexcept {
+			if (ptr) {
+				AllocationTracker::RecordDeallocation(_Tag(), size * sizeof(T));
+			}
+			_inner.deallocate(ptr, size);
+		}
+
+		template<typename... Args>
+		inline void construct(T* ptr, Args&&... args) {
+			_inner.construct(ptr, std::forward<Args>(args)...);
+		}
+
+		inline void destroy(T* ptr) noexcept {
+			_inner.destroy(ptr);
+		}
+
+		inline const Inner& GetInner() const noexcept {
+			return _inner;
+		}
+
+		friend bool operator==(const TrackingAllocator& a, const TrackingAllocator& b) {
+			return a._inner == b._inner;
+		}
+
+		friend bool operator!=(const TrackingAllocator& a, const TrackingAllocator& b) {
+			return !(a._inner == b._inner);
+		}
+
+	private:
+
+		static inline uint32_t _Tag() {
+			return AllocationTracker::TagId<Tag>();
+		}
+
+		[[no_unique_address]] Inner _inner;
+	};
+
+	template<typename T, typename Tag, typename Inner>
+	struct TriviallyRelocatable<TrackingAllocator<T, Tag, Inner>> {
+		static constexpr inline bool value = trivially_relocatable<Inner>;
+	};
+
+#else
+
+	template<typename T, typename Tag, typename Inner = DynamicAllocator<T>>
+	using TrackingAllocator = Inner;
+
+#endif
+
+	// tags used by the engine's own containers
+	namespace allocation_tags {
+
+		struct Threads {
+			static constexpr inline const char* name = "Map<Thread>";
+		};
+
+		struct RenderingContext {
+			static constexpr inline const char* name = "RenderingContext";
+		};
+
+		struct Fields {
+			static constexpr inline const char* name = "Field";
+		};
+	}
+}
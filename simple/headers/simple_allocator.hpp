@@ -1,24 +1,178 @@
 #pragma once
 
+#include <concepts>
 #include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <type_traits>
 #include <utility>
 
 namespace simple {
 
+	// Types that can be moved to a new address with a plain memcpy and without running the destructor on the old address.
+	// Trivially copyable types qualify automatically, other types opt in by specializing this struct.
+	template<typename T>
+	struct TriviallyRelocatable {
+		static constexpr inline bool value = std::is_trivially_copyable_v<T>;
+	};
+
+	template<typename T>
+	constexpr inline bool trivially_relocatable = TriviallyRelocatable<T>::value;
+
+	// Alignment malloc (and plain operator new) guarantee, anything above it goes through the std::align_val_t overloads.
+	constexpr inline size_t default_alignment = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+	// Size of the unit cpu caches transfer between cores. Data written by different threads should not share one (false sharing).
+	constexpr inline size_t cache_line_size = 64;
+
+	// Memory from AlignedAllocate has to be released with AlignedReallocate or AlignedDeallocate and the same alignment.
+	// Returns nullptr on failure like malloc.
+	inline void* AlignedAllocate(size_t size, size_t alignment) noexcept {
+		if (alignment <= default_alignment) {
+			return std::malloc(size);
+		}
+		return ::operator new(size, std::align_val_t(alignment), std::nothrow);
+	}
+
+	// the contents of ptr stay valid if this fails
+	inline void* AlignedReallocate(void* ptr, size_t oldSize, size_t newSize, size_t alignment) noexcept {
+		if (alignment <= default_alignment) {
+			return std::realloc(ptr, newSize);
+		}
+		void* result = ::operator new(newSize, std::align_val_t(alignment), std::nothrow);
+		if (result && ptr) {
+			std::memcpy(result, ptr, oldSize < newSize ? oldSize : newSize);
+			::operator delete(ptr, std::align_val_t(alignment));
+		}
+		return result;
+	}
+
+	inline void AlignedDeallocate(void* ptr, size_t alignment) noexcept {
+		if (alignment <= default_alignment) {
+			std::free(ptr);
+			return;
+		}
+		::operator delete(ptr, std::align_val_t(alignment));
+	}
+
+	// Gives a value a cache line (or more) of its own, for per thread data that lives next to other threads' data, e.g.
+	// counters or atomics in an array indexed by thread or shard.
+	template<typename T>
+	struct alignas(cache_line_size) CachePadded {
+
+		T value;
+
+		template<typename... Args> requires std::constructible_from<T, Args...>
+		constexpr inline CachePadded(Args&&... args) : value(std::forward<Args>(args)...) {}
+
+		constexpr inline T& operator*() noexcept {
+			return value;
+		}
+
+		constexpr inline const T& operator*() const noexcept {
+			return value;
+		}
+
+		constexpr inline T* operator->() noexcept {
+			return &value;
+		}
+
+		constexpr inline const T* operator->() const noexcept {
+			return &value;
+		}
+	};
+
+	// Allocators that can grow an allocation in place (or move it without element-wise construction) provide reallocate.
+	template<typename Allocator, typename T>
+	concept ReallocatingAllocator = requires(Allocator allocator, T* ptr, size_t size) {
+		{ allocator.reallocate(ptr, size, size) } -> std::same_as<T*>;
+	};
+
+	// The allocator of the same kind for U, used by containers that allocate more than one type (e.g. the control bytes next to
+	// the entries of a hash table), so all of their memory comes from the same place. Allocators whose first template argument
+	// is the element type and that convert from each other get this for free, any other allocator provides rebind<U>::other
+	// like for std::allocator_traits.
+	template<typename Allocator, typename U>
+	struct AllocatorRebind {
+		using type = typename Allocator::template rebind<U>::other;
+	};
+
+	template<template<typename, typename...> typename Allocator, typename T, typename... Args, typename U>
+		requires (!requires { typename Allocator<T, Args...>::template rebind<U>::other; })
+	struct AllocatorRebind<Allocator<T, Args...>, U> {
+		using type = Allocator<U, Args...>;
+	};
+
+	// How containers treat their allocator when they're copied, moved or swapped. Allocators opt in with the same member
+	// types as for std::allocator_traits (propagate_on_container_copy_assignment, propagate_on_container_move_assignment,
+	// propagate_on_container_swap, is_always_equal and select_on_container_copy_construction), empty allocators are always equal.
+	// Containers whose allocators neither propagate nor compare equal move their elements one by one instead of stealing memory.
+	template<typename Allocator>
+	struct AllocatorTraits {
+
+		static constexpr inline bool propagate_on_copy = requires { requires Allocator::propagate_on_container_copy_assignment::value; };
+		static constexpr inline bool propagate_on_move = requires { requires Allocator::propagate_on_container_move_assignment::value; };
+		static constexpr inline bool propagate_on_swap = requires { requires Allocator::propagate_on_container_swap::value; };
+
+		static constexpr inline bool always_equal = []() {
+			if constexpr (requires { Allocator::is_always_equal::value; }) {
+				return Allocator::is_always_equal::value;
+			}
+			else {
+				return std::is_empty_v<Allocator>;
+			}
+		}();
+
+		template<typename U>
+		using Rebind = typename AllocatorRebind<Allocator, U>::type;
+
+		// the allocator a copy constructed container uses
+		static constexpr inline Allocator SelectOnCopy(const Allocator& allocator) {
+			if constexpr (requires { { allocator.select_on_container_copy_construction() } -> std::convertible_to<Allocator>; }) {
+				return allocator.select_on_container_copy_construction();
+			}
+			else {
+				return allocator;
+			}
+		}
+
+		static constexpr inline bool Equal(const Allocator& a, const Allocator& b) {
+			if constexpr (always_equal) {
+				return true;
+			}
+			else {
+				return a == b;
+			}
+		}
+	};
+
 	template<typename T>
 	class DynamicAllocator {
 	public:
 
+		using is_always_equal = std::true_type;
+
 		inline DynamicAllocator() = default;
 
 		constexpr inline DynamicAllocator(const DynamicAllocator&) noexcept { }
 
+		template<typename U>
+		constexpr inline DynamicAllocator(const DynamicAllocator<U>&) noexcept {}
+
+		// over-aligned types get their alignment, everything else comes straight from malloc
 		T* allocate(size_t size) {
-			return static_cast<T*>(::operator new(size * sizeof(T)));
+			return static_cast<T*>(AlignedAllocate(size * sizeof(T), alignof(T)));
+		}
+
+		// only valid for trivially relocatable types, since the bytes are moved without calling any constructors
+		T* reallocate(T* ptr, size_t oldSize, size_t newSize) {
+			static_assert(trivially_relocatable<T>, "attempting to reallocate memory of a type that's not trivially relocatable (function simple::DynamicAllocator::reallocate)!");
+			return static_cast<T*>(AlignedReallocate(ptr, oldSize * sizeof(T), newSize * sizeof(T), alignof(T)));
 		}
 
 		void deallocate(T* ptr, size_t size) noexcept {
-			::operator delete(ptr);
+			AlignedDeallocate(ptr, alignof(T));
 		}
 
 		template<typename... Args>
@@ -38,4 +192,110 @@ namespace simple {
 			return false;
 		}
 	};
+
+	template<typename T>
+	struct TriviallyRelocatable<DynamicAllocator<T>> {
+		static constexpr inline bool value = true;
+	};
+
+	// Allocates with at least T_alignment, e.g. simple::DynamicArray<Vec4, simple::AlignedAllocator<Vec4, 32>> for aligned
+	// SIMD loads or simple::AlignedAllocator<T, simple::cache_line_size> to keep arrays from sharing cache lines.
+	template<typename T, size_t T_alignment>
+	class AlignedAllocator {
+	public:
+
+		static_assert(T_alignment && !(T_alignment & (T_alignment - 1)), "alignment must be a power of two (simple::AlignedAllocator)!");
+
+		static constexpr inline size_t alignment = T_alignment > alignof(T) ? T_alignment : alignof(T);
+
+		using is_always_equal = std::true_type;
+
+		// the alignment isn't a type, so it can't be rebound automatically
+		template<typename U>
+		struct rebind {
+			using other = AlignedAllocator<U, T_alignment>;
+		};
+
+		inline AlignedAllocator() = default;
+
+		constexpr inline AlignedAllocator(const AlignedAllocator&) noexcept {}
+
+		template<typename U>
+		constexpr inline AlignedAllocator(const AlignedAllocator<U, T_alignment>&) noexcept {}
+
+		inline T* allocate(size_t size) {
+			return static_cast<T*>(AlignedAllocate(size * sizeof(T), alignment));
+		}
+
+		// only valid for trivially relocatable types, since the bytes are moved without calling any constructors
+		inline T* reallocate(T* ptr, size_t oldSize, size_t newSize) {
+			static_assert(trivially_relocatable<T>, "attempting to reallocate memory of a type that's not trivially relocatable (function simple::AlignedAllocator::reallocate)!");
+			return static_cast<T*>(AlignedReallocate(ptr, oldSize * sizeof(T), newSize * sizeof(T), alignment));
+		}
+
+		inline void deallocate(T* ptr, size_t size) noexcept {
+			AlignedDeallocate(ptr, alignment);
+		}
+
+		template<typename... Args>
+		inline void construct(T* ptr, Args&&... args) {
+			new(ptr) T(std::forward<Args>(args)...);
+		}
+
+		inline void destroy(T* ptr) noexcept {
+			ptr->~T();
+		}
+
+		friend bool operator==(const AlignedAllocator&, const AlignedAllocator&) {
+			return true;
+		}
+
+		friend bool operator!=(const AlignedAllocator&, const AlignedAllocator&) {
+			return false;
+		}
+	};
+
+	template<typename T, size_t T_alignment>
+	struct TriviallyRelocatable<AlignedAllocator<T, T_alignment>> {
+		static constexpr inline bool value = true;
+	};
+
+	// Moves count objects from src to dst (ranges may overlap), leaving src as raw memory.
+	template<typename T, typename Allocator>
+	inline void Relocate(Allocator& allocator, T* dst, T* src, size_t count) {
+		if (dst == src || !count) {
+			return;
+		}
+		if constexpr (trivially_relocatable<T>) {
+			std::memmove((void*)dst, (const void*)src, count * sizeof(T));
+		}
+		else if (dst < src) {
+			for (size_t i = 0; i < count; i++) {
+				allocator.construct(&dst[i], std::move(src[i]));
+				allocator.destroy(&src[i]);
+			}
+		}
+		else {
+			for (size_t i = count; i > 0; i--) {
+				allocator.construct(&dst[i - 1], std::move(src[i - 1]));
+				allocator.destroy(&src[i - 1]);
+			}
+		}
+	}
+
+	// Copy constructs count objects from src into the raw memory at dst (ranges may not overlap).
+	template<typename T, typename Allocator>
+	inline void UninitializedCopy(Allocator& allocator, T* dst, const T* src, size_t count) {
+		if (!count) {
+			return;
+		}
+		if constexpr (std::is_trivially_copyable_v<T>) {
+			std::memcpy((void*)dst, (const void*)src, count * sizeof(T));
+		}
+		else {
+			for (size_t i = 0; i < count; i++) {
+				allocator.construct(&dst[i], src[i]);
+			}
+		}
+	}
 }
@@ -0,0 +1,152 @@
+#pragma once
+
+#include "simple_allocator.hpp"
+#include "simple_dynamic_array.hpp"
+#include "simple_simd.hpp"
+#include <assert.h>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <type_traits>
+
+namespace simple {
+
+	// Lock-free multi producer, single consumer append buffer.
+	// Any thread can Push, only one thread at a time may Drain. Values are stored in fixed size segments,
+	// Drain detaches all filled segments with one atomic exchange and recycles them for later pushes.
+	template<typename T, uint32_t T_segment_size = 64>
+	class AppendBuffer {
+	public:
+
+		static_assert(std::is_trivially_copyable_v<T>, "simple::AppendBuffer only supports trivially copyable types!");
+		static_assert(T_segment_size > 0, "simple::AppendBuffer segment size must be greater than zero!");
+
+		inline AppendBuffer() : _head(_NewSegment()), _freeSegments(nullptr), _popping() {}
+
+		AppendBuffer(const AppendBuffer&) = delete;
+		AppendBuffer(AppendBuffer&&) = delete;
+
+		inline void Push(const T& value) {
+			for (;;) {
+				Segment* segment = _head.load(std::memory_order_seq_cst);
+				segment->users.fetch_add(1, std::memory_order_seq_cst);
+				if (_head.load(std::memory_order_seq_cst) != segment) {
+					// segment was detached by Drain after we loaded it
+					segment->users.fetch_sub(1, std::memory_order_release);
+					continue;
+				}
+				uint32_t index = segment->reserved.fetch_add(1, std::memory_order_relaxed);
+				if (index < T_segment_size) {
+					segment->values[index] = value;
+					segment->users.fetch_sub(1, std::memory_order_release);
+					return;
+				}
+				segment->users.fetch_sub(1, std::memory_order_release);
+				Segment* fresh = _PopFreeSegment();
+				fresh->next = segment;
+				if (!_head.compare_exchange_strong(segment, fresh, std::memory_order_seq_cst)) {
+					// another producer or Drain replaced the head first
+					_PushFreeSegment(fresh);
+				}
+			}
+		}
+
+		// Appends every value pushed so far to out, oldest segment first. Must only be called from one thread at a time.
+		template<typename Array>
+		inline void Drain(Array& out) {
+			Segment* detached = _head.exchange(_PopFreeSegment(), std::memory_order_seq_cst);
+			Segment* oldest = nullptr;
+			while (detached) {
+				Segment* next = detached->next;
+				detached->next = oldest;
+				oldest = detached;
+				detached = next;
+			}
+			while (oldest) {
+				// Dekker style handshake with Push: the head exchange above and this load, and the producer's users increment
+				// and head reload, are all seq_cst, so either the producer sees the new head and backs off or this sees its count
+				for (uint32_t spins = 0; oldest->users.load(std::memory_order_seq_cst); spins++) {
+					// a producer is still writing to this segment, it may have been preempted so stop spinning after a while
+					if (spins < max_spin_count) {
+						_Pause();
+					}
+					else {
+						std::this_thread::yield();
+					}
+				}
+				uint32_t count = oldest->reserved.load(std::memory_order_relaxed);
+				count = count < T_segment_size ? count : T_segment_size;
+				out.AppendRange(oldest->values, oldest->values + count);
+				Segment* next = oldest->next;
+				oldest->reserved.store(0, std::memory_order_relaxed);
+				_PushFreeSegment(oldest);
+				oldest = next;
+			}
+		}
+
+		inline ~AppendBuffer() {
+			_DeleteChain(_head.load(std::memory_order_acquire));
+			_DeleteChain(_freeSegments.load(std::memory_order_acquire));
+		}
+
+	private:
+
+		static constexpr inline uint32_t max_spin_count = 64;
+
+		static inline void _Pause() noexcept {
+#ifdef SIMPLE_SSE2
+			_mm_pause();
+#endif
+		}
+
+		struct Segment {
+			std::atomic<uint32_t> reserved{};
+			std::atomic<uint32_t> users{};
+			Segment* next{};
+			T values[T_segment_size];
+		};
+
+		inline Segment* _NewSegment() {
+			DynamicAllocator<Segment> allocator{};
+			Segment* segment = allocator.allocate(1);
+			assert(segment && "failed to allocate memory!");
+			allocator.construct(segment);
+			return segment;
+		}
+
+		// Only one thread pops at a time (others fall back to allocating), which keeps the free list free of ABA
+		// since segments are only ever pushed back by whoever popped them.
+		inline Segment* _PopFreeSegment() {
+			if (_popping.test_and_set(std::memory_order_acquire)) {
+				return _NewSegment();
+			}
+			Segment* segment = _freeSegments.load(std::memory_order_acquire);
+			while (segment && !_freeSegments.compare_exchange_weak(segment, segment->next, std::memory_order_acquire)) {}
+			_popping.clear(std::memory_order_release);
+			if (!segment) {
+				return _NewSegment();
+			}
+			segment->next = nullptr;
+			return segment;
+		}
+
+		inline void _PushFreeSegment(Segment* segment) {
+			segment->next = _freeSegments.load(std::memory_order_relaxed);
+			while (!_freeSegments.compare_exchange_weak(segment->next, segment, std::memory_order_release)) {}
+		}
+
+		inline void _DeleteChain(Segment* segment) {
+			DynamicAllocator<Segment> allocator{};
+			while (segment) {
+				Segment* next = segment->next;
+				allocator.destroy(segment);
+				allocator.deallocate(segment, 1);
+				segment = next;
+			}
+		}
+
+		alignas(cache_line_size) std::atomic<Segment*> _head;
+		alignas(cache_line_size) std::atomic<Segment*> _freeSegments;
+		std::atomic_flag _popping;
+	};
+}
@@ -0,0 +1,165 @@
+#pragma once
+
+#include "simple_allocator.hpp"
+#include "simple_hash.hpp"
+#include "simple_map.hpp"
+#include "simple_tuple.hpp"
+#include <assert.h>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <utility>
+
+namespace simple {
+
+	// Thread safe hash map split into T_shard_count independently locked simple::Map shards.
+	// Lookups only take a shared lock on one shard, so readers never block each other and writers only block
+	// the keys that hash to the same shard. Values are allocated individually, so pointers to them stay valid
+	// until the value is erased, which makes them safe to cache (e.g. in thread_local variables).
+	template<typename Key, typename Val, typename Hasher, uint32_t T_shard_count = 16, typename Allocator = DynamicAllocator<Val>>
+	class ConcurrentMap {
+	public:
+
+		static_assert(T_shard_count && !(T_shard_count & (T_shard_count - 1)), "simple::ConcurrentMap shard count must be a power of two!");
+
+		inline ConcurrentMap() : ConcurrentMap(Allocator()) {}
+
+		// allocator is used for the values and, rebound, for the tables of the shards
+		explicit inline ConcurrentMap(const Allocator& allocator) : ConcurrentMap(allocator, std::make_index_sequence<T_shard_count>()) {}
+
+		ConcurrentMap(const ConcurrentMap&) = delete;
+		ConcurrentMap(ConcurrentMap&&) = delete;
+
+		// constructs the value from args if key isn't in the map yet
+		template<typename... Args>
+		inline Tuple<bool, Val*> Emplace(const Key& key, Args&&... args) {
+			uint64_t hash = _Hash(key);
+			Shard& shard = _GetShard(hash);
+			std::unique_lock lock(shard.mutex);
+			auto existing = shard.map.FindWithHash(key, hash);
+			if (existing) {
+				return { false, existing->second };
+			}
+			Val* val = _allocator.allocate(1);
+			assert(val && "failed to allocate memory!");
+			_allocator.construct(val, std::forward<Args>(args)...);
+			shard.map.InsertWithHash({ key, val }, hash);
+			_size.fetch_add(1, std::memory_order_relaxed);
+			return { true, val };
+		}
+
+		inline Tuple<bool, Val*> Insert(const Key& key, const Val& val) {
+			return Emplace(key, val);
+		}
+
+		inline Val* Find(const Key& key) const {
+			uint64_t hash = _Hash(key);
+			const Shard& shard = _GetShard(hash);
+			std::shared_lock lock(shard.mutex);
+			auto pair = shard.map.FindWithHash(key, hash);
+			return pair ? pair->second : nullptr;
+		}
+
+		inline bool Contains(const Key& key) const {
+			uint64_t hash = _Hash(key);
+			const Shard& shard = _GetShard(hash);
+			std::shared_lock lock(shard.mutex);
+			return shard.map.FindWithHash(key, hash) != nullptr;
+		}
+
+		// destroys the value, pointers to it become invalid
+		inline bool Erase(const Key& key) {
+			uint64_t hash = _Hash(key);
+			Shard& shard = _GetShard(hash);
+			std::unique_lock lock(shard.mutex);
+			auto pair = shard.map.FindWithHash(key, hash);
+			if (!pair) {
+				return false;
+			}
+			Val* val = pair->second;
+			shard.map.EraseWithHash(key, hash);
+			_allocator.destroy(val);
+			_allocator.deallocate(val, 1);
+			_size.fetch_sub(1, std::memory_order_relaxed);
+			return true;
+		}
+
+		// calls func(const Key&, Val&) for every entry, each shard is exclusively locked while it's visited
+		template<typename Func>
+		inline void ForEach(Func&& func) {
+			for (Shard& shard : _shards) {
+				std::unique_lock lock(shard.mutex);
+				for (auto& pair : shard.map) {
+					func(pair.first, *pair.second);
+				}
+			}
+		}
+
+		inline void Clear() {
+			for (Shard& shard : _shards) {
+				std::unique_lock lock(shard.mutex);
+				for (auto& pair : shard.map) {
+					_allocator.destroy(pair.second);
+					_allocator.deallocate(pair.second, 1);
+				}
+				_size.fetch_sub(shard.map.Size(), std::memory_order_relaxed);
+				shard.map.Clear();
+			}
+		}
+
+		// only exact while no other thread modifies the map
+		inline size_t Size() const noexcept {
+			return _size.load(std::memory_order_relaxed);
+		}
+
+		inline ~ConcurrentMap() {
+			Clear();
+		}
+
+	private:
+
+		typedef typename AllocatorTraits<Allocator>::template Rebind<Pair<Key, Val*>> ShardAllocator;
+		typedef DenseMap<Key, Val*, Hasher, ShardAllocator> ShardMap;
+
+		struct Shard {
+
+			inline Shard(const Allocator& allocator) : map(ShardAllocator(allocator)) {}
+
+			// keeps shards on separate cache lines so locking one doesn't invalidate its neighbours
+			alignas(cache_line_size) mutable std::shared_mutex mutex{};
+			ShardMap map;
+		};
+
+		static constexpr inline uint32_t shard_shift = 64 - std::countr_zero(T_shard_count);
+
+		// the same hash the shard maps use, so it's computed once per operation
+		static inline uint64_t _Hash(const Key& key) {
+			return ShardMap::HashKey(key);
+		}
+
+		// the shard is picked from the top bits of the hash, the shard maps probe with the low bits
+		inline Shard& _GetShard(uint64_t hash) noexcept {
+			if constexpr (T_shard_count == 1) {
+				return _shards[0];
+			}
+			else {
+				return _shards[hash >> shard_shift];
+			}
+		}
+
+		inline const Shard& _GetShard(uint64_t hash) const noexcept {
+			return const_cast<ConcurrentMap*>(this)->_GetShard(hash);
+		}
+
+		// the shards aren't movable, so every one of them is constructed in place from the allocator
+		template<size_t... T_indices>
+		inline ConcurrentMap(const Allocator& allocator, std::index_sequence<T_indices...>)
+			: _allocator(allocator), _shards{ ((void)T_indices, Shard(allocator))... }, _size(0) {}
+
+		Allocator _allocator;
+		Shard _shards[T_shard_count];
+		std::atomic<size_t> _size;
+	};
+}
@@ -1,8 +1,11 @@
 #pragma once
 
 #include "simple_allocator.hpp"
+#include "simple_simd.hpp"
 #include <assert.h>
+#include <cstddef>
 #include <cstdint>
+#include <type_traits>
 
 namespace simple {
 
@@ -15,38 +18,43 @@ namespace simple {
 
 		constexpr inline DynamicArray() : _allocator(), _capacity(0), _size(0), _pData(nullptr) {}
 
-		constexpr inline DynamicArray(Iterator begin, ConstIterator end) : _allocator(), _capacity(0), _size(0), _pData(nullptr) {
-			ptrdiff_t diff = end - begin;
-			assert(diff >= 0 && diff < UINT32_MAX);
-			Reserve(diff);
-			for (; begin != end;) {
-				PushBack(*begin);
-				++begin;
-			}
+		constexpr explicit inline DynamicArray(const Allocator& allocator) noexcept : _allocator(allocator), _capacity(0), _size(0), _pData(nullptr) {}
+
+		constexpr inline DynamicArray(ConstIterator begin, ConstIterator end, const Allocator& allocator = Allocator())
+			: _allocator(allocator), _capacity(0), _size(0), _pData(nullptr) {
+			AppendRange(begin, end);
 		}
 
-		constexpr inline DynamicArray(const DynamicArray& other) noexcept 
-			: _allocator(), _capacity(other._capacity), _size(other._size), _pData(nullptr) {
-			if (other._capacity == 0) {
-				return;
-			}
-			_pData = _allocator.allocate(_capacity);
-			for (size_t i = 0; i < other._size; i++) {
-				_allocator.construct(&_pData[i], other._pData[i]);
-			}
+		constexpr inline DynamicArray(const DynamicArray& other)
+			: DynamicArray(other, AllocatorTraits<Allocator>::SelectOnCopy(other._allocator)) {}
+
+		constexpr inline DynamicArray(const DynamicArray& other, const Allocator& allocator)
+			: _allocator(allocator), _capacity(0), _size(0), _pData(nullptr) {
+			AppendRange(other.begin(), other.end());
 		}
 
 		constexpr inline DynamicArray(DynamicArray&& other) noexcept 
-			: _allocator(), _capacity(other._capacity), _size(other._size), _pData(other._pData) {
+			: _allocator(other._allocator), _capacity(other._capacity), _size(other._size), _pData(other._pData) {
 			other._capacity = 0;
 			other._size = 0;
 			other._pData = nullptr;
 		}
 
-		constexpr inline DynamicArray(uint32_t size) : _allocator(), _capacity(0), _size(0), _pData(nullptr) {
+		// steals the memory of other if the allocators are equal, moves the elements one by one otherwise
+		constexpr inline DynamicArray(DynamicArray&& other, const Allocator& allocator)
+			: _allocator(allocator), _capacity(0), _size(0), _pData(nullptr) {
+			_MoveFrom(other);
+		}
+
+		constexpr inline DynamicArray(uint32_t size, const Allocator& allocator = Allocator())
+			: _allocator(allocator), _capacity(0), _size(0), _pData(nullptr) {
 			Resize(size);
 		}
 
+		constexpr inline const Allocator& GetAllocator() const noexcept {
+			return _allocator;
+		}
+
 		constexpr inline uint32_t Capacity() const noexcept {
 			return _capacity;
 		}
@@ -63,28 +71,57 @@ namespace simple {
 			if (capacity <= _capacity || capacity == 0) {
 				return *this;
 			}
+			uint32_t oldCapacity = _capacity;
 			_capacity = _capacity ? _capacity : 1;
 			while (_capacity < capacity) {
 				_capacity *= 2;
 			}
+			if constexpr (trivially_relocatable<T> && ReallocatingAllocator<Allocator, T>) {
+				T* temp = _allocator.reallocate(_pData, oldCapacity, _capacity);
+				assert(temp && "failed to allocate memory!");
+				_pData = temp;
+				return *this;
+			}
 			T* temp = _allocator.allocate(_capacity);
 			assert(temp && "failed to allocate memory!");
-			for (size_t i = 0; i < _size; i++) {
-				_allocator.construct(&temp[i], std::move(_pData[i]));
-			}
-			_allocator.deallocate(_pData, 1);
+			Relocate(_allocator, temp, _pData, _size);
+			_allocator.deallocate(_pData, oldCapacity);
 			_pData = temp;
 			return *this;
 		}
 
+		// value initializes the new elements
 		constexpr inline DynamicArray& Resize(uint32_t size) {
-			if (size > _capacity) {
-				Reserve(size);
+			Reserve(size);
+			for (uint32_t i = size; i < _size; i++) {
+				_allocator.destroy(&_pData[i]);
 			}
-			_size = size;
-			for (size_t i = 0; i < _size; i++) {
+			for (uint32_t i = _size; i < size; i++) {
 				_allocator.construct(&_pData[i]);
 			}
+			_size = size;
+			return *this;
+		}
+
+		// default initializes the new elements, which leaves trivial types uninitialized
+		constexpr inline DynamicArray& ResizeDefault(uint32_t size) {
+			Reserve(size);
+			for (uint32_t i = size; i < _size; i++) {
+				_allocator.destroy(&_pData[i]);
+			}
+			for (uint32_t i = _size; i < size; i++) {
+				new(&_pData[i]) T;
+			}
+			_size = size;
+			return *this;
+		}
+
+		// changes the size without touching the elements, meant for buffers that are written to right after (e.g. by vulkan)
+		constexpr inline DynamicArray& ResizeUninitialized(uint32_t size) {
+			static_assert(std::is_trivially_default_constructible_v<T> && std::is_trivially_destructible_v<T>,
+				"attempting to call simple::DynamicArray::ResizeUninitialized with a type that isn't trivial!");
+			Reserve(size);
+			_size = size;
 			return *this;
 		}
 
@@ -98,18 +135,7 @@ namespace simple {
 		}
 
 		constexpr inline Iterator Insert(Iterator where, const T& value) {
-			if (where == &_pData[_size]) {
-				return pushBack(value);
-			}
-			if (_size >= _capacity) {
-				Reserve((_capacity ? _capacity : 1) * 2);
-			}
-			for (auto iter = &_pData[_size]; iter != where; iter--) {
-				_allocator.construct(iter, std::move(*(iter - 1)));
-			}
-			_allocator.construct(where, value);
-			++_size;
-			return where;
+			return Emplace(where, value);
 		}
 
 		template<typename... Args>
@@ -123,32 +149,97 @@ namespace simple {
 
 		template<typename... Args>
 		constexpr inline Iterator Emplace(Iterator where, Args&&... args) {
-			if (where == &_pData[_size]) {
-				return emplaceBack(std::forward<Args>(args)...);
+			ptrdiff_t index = where - _pData;
+			assert(index >= 0 && index <= _size
+				&& "attempting to emplace to simple::DynamicArray (function simple::DynamicArray::Emplace) with an iterator that doesn't belong to the simple::DynamicArray");
+			if (index == _size) {
+				return &EmplaceBack(std::forward<Args>(args)...);
 			}
+			T value(std::forward<Args>(args)...);
 			if (_size >= _capacity) {
 				Reserve((_capacity ? _capacity : 1) * 2);
 			}
-			for (auto iter = &_pData[_size]; iter != where; iter--) {
-				_allocator.construct(iter, std::move(*(iter - 1)));
-			}
-			_allocator.construct(where, std::forward<Args>(args)...);
+			where = &_pData[index];
+			Relocate(_allocator, where + 1, where, _size - index);
+			_allocator.construct(where, std::move(value));
 			++_size;
 			return where;
 		}
 
 		constexpr inline Iterator Erase(Iterator where) {
-			Iterator iter = where;
-			ptrdiff_t ptrdiff = iter - &_pData[0];
-			assert(ptrdiff < _size && ptrdiff >= 0
+			ptrdiff_t index = where - _pData;
+			assert(index < _size && index >= 0
 				&& "attempting to erase from simple::DynamicArray (function simple::DynamicArray::Erase) with an iterator that doesn't belong to the simple::DynamicArray");
-			while (iter != &_pData[_size - 1]) {
+			_allocator.destroy(where);
+			Relocate(_allocator, where, where + 1, _size - index - 1);
+			--_size;
+			return &_pData[index];
+		}
+
+		// O(1) erase that moves the last element into the erased slot, so element order is not preserved
+		constexpr inline Iterator EraseUnordered(Iterator where) {
+			ptrdiff_t index = where - _pData;
+			assert(index < _size && index >= 0
+				&& "attempting to erase from simple::DynamicArray (function simple::DynamicArray::EraseUnordered) with an iterator that doesn't belong to the simple::DynamicArray");
+			_allocator.destroy(where);
+			--_size;
+			if (index != _size) {
+				Relocate(_allocator, where, &_pData[_size], 1);
+			}
+			return where;
+		}
+
+		constexpr inline DynamicArray& AppendRange(ConstIterator begin, ConstIterator end) {
+			ptrdiff_t count = end - begin;
+			assert(count >= 0 && _size + count <= UINT32_MAX && "invalid range (function simple::DynamicArray::AppendRange)!");
+			if (!count) {
+				return *this;
+			}
+			// the range may lie in this array, which reserving can free, pointers into other arrays can't be subtracted from _pData
+			bool fromSelf = begin >= _pData && begin < _pData + _size;
+			ptrdiff_t selfOffset = fromSelf ? begin - _pData : 0;
+			Reserve(_size + (uint32_t)count);
+			if (fromSelf) {
+				begin = &_pData[selfOffset];
+			}
+			UninitializedCopy(_allocator, &_pData[_size], begin, count);
+			_size += (uint32_t)count;
+			return *this;
+		}
+
+		constexpr inline Iterator InsertRange(Iterator where, ConstIterator begin, ConstIterator end) {
+			ptrdiff_t index = where - _pData;
+			ptrdiff_t count = end - begin;
+			assert(index >= 0 && index <= _size
+				&& "attempting to insert to simple::DynamicArray (function simple::DynamicArray::InsertRange) with an iterator that doesn't belong to the simple::DynamicArray");
+			assert(count >= 0 && _size + count <= UINT32_MAX && "invalid range (function simple::DynamicArray::InsertRange)!");
+			if (index == _size) {
+				AppendRange(begin, end);
+				return &_pData[index];
+			}
+			if (!count) {
+				return where;
+			}
+			assert((begin >= &_pData[_size] || end <= _pData) && "attempting to insert a range of the simple::DynamicArray into itself (function simple::DynamicArray::InsertRange)!");
+			Reserve(_size + (uint32_t)count);
+			where = &_pData[index];
+			Relocate(_allocator, where + count, where, _size - index);
+			UninitializedCopy(_allocator, where, begin, count);
+			_size += (uint32_t)count;
+			return where;
+		}
+
+		constexpr inline Iterator EraseRange(Iterator first, Iterator last) {
+			ptrdiff_t index = first - _pData;
+			ptrdiff_t count = last - first;
+			assert(index >= 0 && count >= 0 && index + count <= _size
+				&& "attempting to erase from simple::DynamicArray (function simple::DynamicArray::EraseRange) with a range that doesn't belong to the simple::DynamicArray");
+			for (Iterator iter = first; iter != last; ++iter) {
 				_allocator.destroy(iter);
-				_allocator.construct(iter, std::move(*(iter + 1)));
-				++iter;
 			}
-			--_size;
-			return &_pData[ptrdiff];
+			Relocate(_allocator, first, last, _size - index - count);
+			_size -= (uint32_t)count;
+			return &_pData[index];
 		}
 
 		constexpr inline Iterator Back() {
@@ -159,13 +250,19 @@ namespace simple {
 			for (size_t i = 0; i < _size; i++) {
 				_allocator.destroy(&_pData[i]);
 			}
+			_allocator.deallocate(_pData, _capacity);
 			_capacity = 0;
 			_size = 0;
-			_allocator.deallocate(_pData, 1);
 			_pData = nullptr;
 		}
 
 		constexpr inline Iterator Find(const T& value) {
+			if constexpr (std::is_integral_v<T>) {
+				if (!std::is_constant_evaluated()) {
+					size_t index = simd::FindValue<T>(_pData, _size, value);
+					return index == simd::npos ? &_pData[_size] : &_pData[index];
+				}
+			}
 			Iterator begin = &_pData[0];
 			for (; begin != &_pData[_size];) {
 				if (*begin == value) {
@@ -180,11 +277,18 @@ namespace simple {
 			if (!_size) {
 				return *this;
 			}
-			for (uint32_t i = 0, j = _size - 1; i != j && i < j;) {
-				T temp(std::move(_pData[i]));
-				_allocator.construct(&_pData[i], std::move(_pData[j]));
-				_allocator.construct(&_pData[j], std::move(temp));
-				++i; --j;
+			for (uint32_t i = 0, j = _size - 1; i < j; ++i, --j) {
+				if constexpr (trivially_relocatable<T>) {
+					alignas(T) unsigned char temp[sizeof(T)];
+					std::memcpy(temp, (const void*)&_pData[i], sizeof(T));
+					std::memcpy((void*)&_pData[i], (const void*)&_pData[j], sizeof(T));
+					std::memcpy((void*)&_pData[j], temp, sizeof(T));
+				}
+				else {
+					T temp(std::move(_pData[i]));
+					_pData[i] = std::move(_pData[j]);
+					_pData[j] = std::move(temp);
+				}
 			}
 			return *this;
 		}
@@ -201,9 +305,9 @@ namespace simple {
 			for (size_t i = 0; i < _size; i++) {
 				_allocator.destroy(&_pData[i]);
 			}
+			_allocator.deallocate(_pData, _capacity);
 			_capacity = 0;
 			_size = 0;
-			_allocator.deallocate(_pData, 1);
 			_pData = nullptr;
 		}
 
@@ -213,19 +317,78 @@ namespace simple {
 		}
 
 		constexpr DynamicArray& operator=(const DynamicArray& other) {
-			_capacity = other._capacity;
-			_size = other._size;
-			_pData = _allocator.allocate(_capacity);
+			if (this == &other) {
+				return *this;
+			}
+			if constexpr (AllocatorTraits<Allocator>::propagate_on_copy) {
+				if (!AllocatorTraits<Allocator>::Equal(_allocator, other._allocator)) {
+					Clear();
+				}
+				_allocator = other._allocator;
+			}
 			for (uint32_t i = 0; i < _size; i++) {
-				_allocator.construct(&_pData[i], other._pData[i]);
+				_allocator.destroy(&_pData[i]);
 			}
+			_size = 0;
+			AppendRange(other.begin(), other.end());
 			return *this;
-		}	
+		}
+
+		constexpr DynamicArray& operator=(DynamicArray&& other) noexcept(AllocatorTraits<Allocator>::propagate_on_move || AllocatorTraits<Allocator>::always_equal) {
+			if (this == &other) {
+				return *this;
+			}
+			Clear();
+			if constexpr (AllocatorTraits<Allocator>::propagate_on_move) {
+				_allocator = other._allocator;
+			}
+			_MoveFrom(other);
+			return *this;
+		}
+
+		// allocators that don't propagate on swap must be equal
+		constexpr inline void Swap(DynamicArray& other) noexcept {
+			if constexpr (AllocatorTraits<Allocator>::propagate_on_swap) {
+				std::swap(_allocator, other._allocator);
+			}
+			else {
+				assert(AllocatorTraits<Allocator>::Equal(_allocator, other._allocator)
+					&& "attempting to swap simple::DynamicArrays with unequal allocators (function simple::DynamicArray::Swap)!");
+			}
+			std::swap(_capacity, other._capacity);
+			std::swap(_size, other._size);
+			std::swap(_pData, other._pData);
+		}
 
 	private:
+
+		// expects this array to be empty and without memory
+		constexpr inline void _MoveFrom(DynamicArray& other) {
+			if (AllocatorTraits<Allocator>::Equal(_allocator, other._allocator)) {
+				_capacity = other._capacity;
+				_size = other._size;
+				_pData = other._pData;
+				other._capacity = 0;
+				other._size = 0;
+				other._pData = nullptr;
+				return;
+			}
+			Reserve(other._size);
+			for (uint32_t i = 0; i < other._size; i++) {
+				_allocator.construct(&_pData[i], std::move(other._pData[i]));
+			}
+			_size = other._size;
+			other.Clear();
+		}
+
 		Allocator _allocator;
 		uint32_t _capacity;
 		uint32_t _size;
 		T* _pData;
 	};
+
+	template<typename T, class Allocator>
+	struct TriviallyRelocatable<DynamicArray<T, Allocator>> {
+		static constexpr inline bool value = trivially_relocatable<Allocator>;
+	};
 }
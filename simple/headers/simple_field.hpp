@@ -1,6 +1,8 @@
 #pragma once
 
+#include "simple_allocation_tracker.hpp"
 #include "simple_dynamic_array.hpp"
+#include "simple_pool_allocator.hpp"
 #include "simple_logging.hpp"
 
 namespace simple {
@@ -88,6 +90,6 @@ namespace simple {
 		}
 
 	private:
-		DynamicArray<Reference*> _references;
+		DynamicArray<Reference*, TrackingAllocator<Reference*, allocation_tags::Fields, PoolAllocator<Reference*>>> _references;
 	};
 }
@@ -0,0 +1,203 @@
+#pragma once
+
+#include "simple_string_view.hpp"
+#include <bit>
+#include <charconv>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+namespace simple {
+
+	// Number formatting into caller provided buffers and number parsing from simple::StringView, none of which allocate.
+	// Formatting functions return the number of characters written (without a null terminator), or 0 if the buffer is too small.
+	// Parsing functions return the number of characters consumed from the start of the text, or 0 if there's no valid number
+	// there (or it doesn't fit in the result type), in which case the result is left unchanged.
+
+	// enough for any integer up to 64 bits including the sign
+	static constexpr inline size_t max_int_chars = 20;
+	// enough for the shortest representation of any double
+	static constexpr inline size_t max_float_chars = 32;
+
+	namespace format {
+
+		inline constexpr char digit_pairs[] =
+			"00010203040506070809"
+			"10111213141516171819"
+			"20212223242526272829"
+			"30313233343536373839"
+			"40414243444546474849"
+			"50515253545556575859"
+			"60616263646566676869"
+			"70717273747576777879"
+			"80818283848586878889"
+			"90919293949596979899";
+
+		inline constexpr char hex_digits[] = "0123456789abcdef";
+
+		// writes the digits right to left ending at end, two at a time, and returns where they start
+		inline char* FormatDigits(char* end, uint64_t value) noexcept {
+			while (value >= 100) {
+				uint32_t pair = static_cast<uint32_t>(value % 100) * 2;
+				value /= 100;
+				*--end = digit_pairs[pair + 1];
+				*--end = digit_pairs[pair];
+			}
+			if (value >= 10) {
+				uint32_t pair = static_cast<uint32_t>(value) * 2;
+				*--end = digit_pairs[pair + 1];
+				*--end = digit_pairs[pair];
+			}
+			else {
+				*--end = static_cast<char>('0' + value);
+			}
+			return end;
+		}
+
+		// checks 8 characters loaded as a little endian integer for being all digits at once
+		constexpr inline bool IsEightDigits(uint64_t chunk) noexcept {
+			return ((chunk & 0xf0f0f0f0f0f0f0f0) | (((chunk + 0x0606060606060606) & 0xf0f0f0f0f0f0f0f0) >> 4)) == 0x3333333333333333;
+		}
+
+		// converts 8 digits loaded as a little endian integer with three multiplications instead of eight
+		constexpr inline uint32_t ParseEightDigits(uint64_t chunk) noexcept {
+			constexpr uint64_t mask = 0x000000ff000000ff;
+			constexpr uint64_t mul1 = 100 + (1000000ULL << 32);
+			constexpr uint64_t mul2 = 1 + (10000ULL << 32);
+			chunk -= 0x3030303030303030;
+			chunk = chunk * 10 + (chunk >> 8);
+			return static_cast<uint32_t>((((chunk & mask) * mul1) + (((chunk >> 16) & mask) * mul2)) >> 32);
+		}
+	}
+
+	template<std::integral T> requires (!std::same_as<T, bool>)
+	inline size_t FormatInt(char* buffer, size_t size, T value) noexcept {
+		using Unsigned = std::make_unsigned_t<T>;
+		bool negative = false;
+		Unsigned magnitude = static_cast<Unsigned>(value);
+		if constexpr (std::is_signed_v<T>) {
+			negative = value < 0;
+			magnitude = negative ? static_cast<Unsigned>(Unsigned(0) - magnitude) : magnitude;
+		}
+		char temp[max_int_chars];
+		char* end = temp + max_int_chars;
+		char* begin = format::FormatDigits(end, magnitude);
+		size_t digits = end - begin;
+		if (digits + negative > size) {
+			return 0;
+		}
+		if (negative) {
+			buffer[0] = '-';
+		}
+		std::memcpy(buffer + negative, begin, digits);
+		return digits + negative;
+	}
+
+	// lowercase hex digits without a prefix, padded with zeros to at least minDigits
+	template<std::integral T> requires (!std::same_as<T, bool>)
+	inline size_t FormatHex(char* buffer, size_t size, T value, uint32_t minDigits = 1) noexcept {
+		uint64_t bits = static_cast<std::make_unsigned_t<T>>(value);
+		size_t digits = (std::bit_width(bits) + 3) / 4;
+		digits = digits > minDigits ? digits : minDigits;
+		digits = digits ? digits : 1;
+		if (digits > size) {
+			return 0;
+		}
+		for (size_t i = digits; i > 0; i--) {
+			buffer[i - 1] = format::hex_digits[bits & 15];
+			bits >>= 4;
+		}
+		return digits;
+	}
+
+	// shortest representation that reads back to the same value
+	template<std::floating_point T>
+	inline size_t FormatFloat(char* buffer, size_t size, T value) noexcept {
+		std::to_chars_result result = std::to_chars(buffer, buffer + size, value);
+		return result.ec == std::errc() ? result.ptr - buffer : 0;
+	}
+
+	// fixed number of digits after the decimal point
+	template<std::floating_point T>
+	inline size_t FormatFloat(char* buffer, size_t size, T value, int precision) noexcept {
+		std::to_chars_result result = std::to_chars(buffer, buffer + size, value, std::chars_format::fixed, precision < 0 ? 0 : precision);
+		return result.ec == std::errc() ? result.ptr - buffer : 0;
+	}
+
+	// decimal integer with an optional sign, digit runs are converted 8 characters at a time
+	template<std::integral T> requires (!std::same_as<T, bool>)
+	inline size_t ParseInt(StringView text, T& result) noexcept {
+		const char* data = text.Data();
+		size_t length = text.Length();
+		size_t i = 0;
+		bool negative = false;
+		if (i < length && (data[i] == '-' || data[i] == '+')) {
+			negative = data[i] == '-';
+			i++;
+			if (negative && std::is_unsigned_v<T>) {
+				return 0;
+			}
+		}
+		size_t digitsBegin = i;
+		uint64_t value = 0;
+		if constexpr (std::endian::native == std::endian::little) {
+			// 8 more digits only fit without overflow checks as long as there's at most 11 digits so far
+			while (i + 8 <= length && i - digitsBegin <= 11) {
+				uint64_t chunk;
+				std::memcpy(&chunk, data + i, 8);
+				if (!format::IsEightDigits(chunk)) {
+					break;
+				}
+				value = value * 100000000 + format::ParseEightDigits(chunk);
+				i += 8;
+			}
+		}
+		for (; i < length && data[i] >= '0' && data[i] <= '9'; i++) {
+			uint64_t digit = data[i] - '0';
+			if (value > (UINT64_MAX - digit) / 10) {
+				return 0;
+			}
+			value = value * 10 + digit;
+		}
+		if (i == digitsBegin) {
+			return 0;
+		}
+		using Unsigned = std::make_unsigned_t<T>;
+		if constexpr (std::is_signed_v<T>) {
+			uint64_t limit = static_cast<uint64_t>(std::numeric_limits<T>::max()) + negative;
+			if (value > limit) {
+				return 0;
+			}
+			result = negative ? static_cast<T>(Unsigned(0) - static_cast<Unsigned>(value)) : static_cast<T>(value);
+		}
+		else {
+			if (value > std::numeric_limits<T>::max()) {
+				return 0;
+			}
+			result = static_cast<T>(value);
+		}
+		return i;
+	}
+
+	// decimal or scientific notation with an optional sign, also accepts inf and nan
+	template<std::floating_point T>
+	inline size_t ParseFloat(StringView text, T& result) noexcept {
+		const char* begin = text.Data();
+		const char* end = text.end();
+		// from_chars doesn't accept a plus sign
+		const char* first = begin != end && *begin == '+' ? begin + 1 : begin;
+		if (first != begin && first != end && *first == '-') {
+			return 0;
+		}
+		T value;
+		std::from_chars_result parsed = std::from_chars(first, end, value);
+		if (parsed.ec != std::errc()) {
+			return 0;
+		}
+		result = value;
+		return parsed.ptr - begin;
+	}
+}
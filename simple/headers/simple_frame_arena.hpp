@@ -0,0 +1,253 @@
+#pragma once
+
+#include "simple_allocator.hpp"
+#include "simple_logging.hpp"
+#include <assert.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+
+namespace simple {
+
+	// Bump pointer allocator for memory that only has to live until the frame that allocated it is finished on the gpu.
+	// Each frame in flight owns one region, BeginFrame rewinds the region of a frame once its fence has been waited on,
+	// freeing everything allocated during that frame at once. Allocating is one atomic add, so any thread can allocate,
+	// but BeginFrame must not run concurrently with allocations. Allocations that don't fit the region fall back to the heap
+	// (freed on the next BeginFrame of the same frame) and show up in the statistics, so the region size can be tuned.
+	class FrameArena {
+	public:
+
+		static constexpr inline uint32_t max_frame_count = 8;
+		static constexpr inline size_t default_region_size = 1024 * 1024;
+		static constexpr inline size_t region_alignment = 64;
+
+		struct Stats {
+			// bytes allocated in the region since its last BeginFrame, overflow included
+			size_t used;
+			// largest number of bytes a single frame has used in the region
+			size_t highWaterMark;
+			// bytes that didn't fit the region during the last completed frame
+			size_t overflow;
+			size_t capacity;
+		};
+
+		inline FrameArena(uint32_t frameCount, size_t regionSize = default_region_size)
+			: _regions(), _frameCount(frameCount), _currentFrame(0) {
+			assert(frameCount && frameCount <= max_frame_count && "invalid frame count (simple::FrameArena constructor)!");
+			regionSize = (regionSize + region_alignment - 1) & ~(region_alignment - 1);
+			for (uint32_t i = 0; i < _frameCount; i++) {
+				Region& region = _regions[i];
+				region.base = static_cast<char*>(AlignedAllocate(regionSize, region_alignment));
+				assert(region.base && "failed to allocate memory (simple::FrameArena constructor)!");
+				region.capacity = regionSize;
+			}
+		}
+
+		FrameArena(const FrameArena&) = delete;
+		FrameArena(FrameArena&&) = delete;
+
+		// the arena default constructed simple::FrameAllocators allocate from
+		static inline void Bind(FrameArena* arena) noexcept {
+			_bound = arena;
+		}
+
+		static inline FrameArena* Bound() noexcept {
+			return _bound;
+		}
+
+		// call once the fence of frameIndex has signaled, invalidates everything allocated the last time frameIndex was current
+		inline void BeginFrame(uint32_t frameIndex) {
+			assert(frameIndex < _frameCount && "frame index out of bounds (function simple::FrameArena::BeginFrame)!");
+			Region& region = _regions[frameIndex];
+			size_t used = region.offset.load(std::memory_order_relaxed) + region.overflowBytes;
+			region.highWaterMark = used > region.highWaterMark ? used : region.highWaterMark;
+			region.lastOverflowBytes = region.overflowBytes;
+			if (region.overflowBytes) {
+				logWarning(this, "frame allocations didn't fit the region and fell back to the heap (warning from simple::FrameArena::BeginFrame)!");
+			}
+			_FreeOverflow(region);
+			region.offset.store(0, std::memory_order_relaxed);
+			_currentFrame = frameIndex;
+		}
+
+		inline void* Allocate(size_t size, size_t alignment) {
+			assert(alignment && !(alignment & (alignment - 1)) && alignment <= region_alignment
+				&& "invalid alignment (function simple::FrameArena::Allocate)!");
+			Region& region = _regions[_currentFrame];
+			size_t offset = region.offset.load(std::memory_order_relaxed);
+			for (;;) {
+				size_t begin = (offset + alignment - 1) & ~(alignment - 1);
+				if (begin + size > region.capacity) {
+					return _AllocateOverflow(region, size);
+				}
+				if (region.offset.compare_exchange_weak(offset, begin + size, std::memory_order_relaxed)) {
+					return region.base + begin;
+				}
+			}
+		}
+
+		// grows the newest allocation of the frame in place, anything else is copied to a new allocation
+		inline void* Reallocate(void* ptr, size_t oldSize, size_t newSize, size_t alignment) {
+			if (!ptr) {
+				return Allocate(newSize, alignment);
+			}
+			Region& region = _regions[_currentFrame];
+			char* bytes = static_cast<char*>(ptr);
+			if (bytes >= region.base && bytes < region.base + region.capacity) {
+				size_t begin = bytes - region.base;
+				size_t end = begin + oldSize;
+				if (begin + newSize <= region.capacity
+					&& region.offset.compare_exchange_strong(end, begin + newSize, std::memory_order_relaxed)) {
+					return ptr;
+				}
+			}
+			void* result = Allocate(newSize, alignment);
+			std::memcpy(result, ptr, oldSize < newSize ? oldSize : newSize);
+			return result;
+		}
+
+		inline uint32_t FrameCount() const noexcept {
+			return _frameCount;
+		}
+
+		inline uint32_t CurrentFrame() const noexcept {
+			return _currentFrame;
+		}
+
+		inline Stats GetStats(uint32_t frameIndex) const {
+			assert(frameIndex < _frameCount && "frame index out of bounds (function simple::FrameArena::GetStats)!");
+			const Region& region = _regions[frameIndex];
+			std::lock_guard lock(region.overflowMutex);
+			size_t used = region.offset.load(std::memory_order_relaxed) + region.overflowBytes;
+			return Stats{
+				.used = used,
+				.highWaterMark = used > region.highWaterMark ? used : region.highWaterMark,
+				.overflow = region.lastOverflowBytes,
+				.capacity = region.capacity,
+			};
+		}
+
+		inline ~FrameArena() {
+			if (_bound == this) {
+				_bound = nullptr;
+			}
+			for (uint32_t i = 0; i < _frameCount; i++) {
+				_FreeOverflow(_regions[i]);
+				AlignedDeallocate(_regions[i].base, region_alignment);
+			}
+		}
+
+	private:
+
+		struct Overflow {
+			Overflow* next;
+		};
+
+		struct Region {
+			char* base = nullptr;
+			size_t capacity = 0;
+			std::atomic<size_t> offset{};
+			size_t highWaterMark = 0;
+			size_t lastOverflowBytes = 0;
+			mutable std::mutex overflowMutex{};
+			Overflow* overflow = nullptr;
+			size_t overflowBytes = 0;
+		};
+
+		inline void* _AllocateOverflow(Region& region, size_t size) {
+			// the header takes a whole alignment unit so the allocation after it is aligned like the region
+			char* memory = static_cast<char*>(AlignedAllocate(region_alignment + size, region_alignment));
+			assert(memory && "failed to allocate memory (function simple::FrameArena::Allocate)!");
+			Overflow* overflow = reinterpret_cast<Overflow*>(memory);
+			std::lock_guard lock(region.overflowMutex);
+			overflow->next = region.overflow;
+			region.overflow = overflow;
+			region.overflowBytes += size;
+			return memory + region_alignment;
+		}
+
+		static inline void _FreeOverflow(Region& region) {
+			std::lock_guard lock(region.overflowMutex);
+			while (region.overflow) {
+				Overflow* next = region.overflow->next;
+				AlignedDeallocate(region.overflow, region_alignment);
+				region.overflow = next;
+			}
+			region.overflowBytes = 0;
+		}
+
+		static inline FrameArena* _bound = nullptr;
+
+		Region _regions[max_frame_count];
+		uint32_t _frameCount;
+		uint32_t _currentFrame;
+	};
+
+	// Allocator adapter for containers whose memory only lives for the current frame, e.g.
+	// simple::DynamicArray<VkCommandBuffer, simple::FrameAllocator<VkCommandBuffer>>.
+	// deallocate does nothing, the memory is reclaimed when the frame's region is reused.
+	// Default constructed adapters use the arena set with simple::FrameArena::Bind.
+	template<typename T>
+	class FrameAllocator {
+	public:
+
+		template<typename U>
+		friend class FrameAllocator;
+
+		inline FrameAllocator() noexcept : _arena(FrameArena::Bound()) {
+			assert(_arena && "no simple::FrameArena bound (simple::FrameAllocator constructor)!");
+		}
+
+		inline FrameAllocator(FrameArena& arena) noexcept : _arena(&arena) {}
+
+		template<typename U>
+		inline FrameAllocator(const FrameAllocator<U>& other) noexcept : _arena(other._arena) {}
+
+		inline T* allocate(size_t size) {
+			return static_cast<T*>(_arena->Allocate(size * sizeof(T), alignof(T)));
+		}
+
+		// only valid for trivially relocatable types, since the bytes are moved without calling any constructors
+		inline T* reallocate(T* ptr, size_t oldSize, size_t newSize) {
+			static_assert(trivially_relocatable<T>, "attempting to reallocate memory of a type that's not trivially relocatable (function simple::FrameAllocator::reallocate)!");
+			return static_cast<T*>(_arena->Reallocate(ptr, oldSize * sizeof(T), newSize * sizeof(T), alignof(T)));
+		}
+
+		// the memory is released all at once when the arena resets
+		inline void deallocate(T*, size_t) noexcept {}
+
+		template<typename... Args>
+		inline void construct(T* ptr, Args&&... args) {
+			new(ptr) T(std::forward<Args>(args)...);
+		}
+
+		inline void destroy(T* ptr) noexcept {
+			ptr->~T();
+		}
+
+		inline FrameArena* GetArena() const noexcept {
+			return _arena;
+		}
+
+		friend bool operator==(const FrameAllocator& a, const FrameAllocator& b) {
+			return a._arena == b._arena;
+		}
+
+		friend bool operator!=(const FrameAllocator& a, const FrameAllocator& b) {
+			return a._arena != b._arena;
+		}
+
+	private:
+
+		FrameArena* _arena;
+	};
+
+	template<typename T>
+	struct TriviallyRelocatable<FrameAllocator<T>> {
+		static constexpr inline bool value = true;
+	};
+}
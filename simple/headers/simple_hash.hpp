@@ -0,0 +1,217 @@
+#pragma once
+
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SIMPLE_SSE2
+#endif
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+namespace simple {
+
+	// Finalizer that spreads the entropy of weak hashes (e.g. identity hashes of integers) over all 64 bits.
+	constexpr inline uint64_t HashMix(uint64_t hash) noexcept {
+		hash ^= hash >> 33;
+		hash *= 0xff51afd7ed558ccdULL;
+		hash ^= hash >> 33;
+		hash *= 0xc4ceb9fe1a85ec53ULL;
+		hash ^= hash >> 33;
+		return hash;
+	}
+
+	// Hashers that declare is_transparent can also hash other types than the key (e.g. const char* for simple::String keys),
+	// hash tables then accept those types in lookups without constructing a key from them
+	template<typename Hasher, typename Key, typename Other>
+	concept TransparentLookup = !std::same_as<std::decay_t<Other>, Key> && requires { typename Hasher::is_transparent; }
+		&& requires(Hasher hasher, const Key& key, const Other& other) {
+			hasher(other);
+			{ key == other } -> std::convertible_to<bool>;
+		};
+
+	// wyhash (final version 4), reads 8 bytes at a time and mixes them with 64x64->128 bit multiplies.
+	// Everything is constexpr so tables built at compile time hash strings the same way as tables built at runtime,
+	// which assumes a little endian target.
+	namespace wyhash {
+
+		constexpr inline uint64_t secret[4] { 0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL, 0x4b33a62ed433d4a3ULL, 0x4d5a2da51de1aa47ULL };
+
+		// full 128 bit product of a and b, low half written to a and high half to b
+		constexpr inline void Mum(uint64_t& a, uint64_t& b) noexcept {
+#if defined(__SIZEOF_INT128__)
+			unsigned __int128 product = (unsigned __int128)a * b;
+			a = (uint64_t)product;
+			b = (uint64_t)(product >> 64);
+#else
+#if defined(_MSC_VER) && defined(_M_X64)
+			if (!std::is_constant_evaluated()) {
+				a = _umul128(a, b, &b);
+				return;
+			}
+#endif
+			uint64_t aHigh = a >> 32, aLow = (uint32_t)a, bHigh = b >> 32, bLow = (uint32_t)b;
+			uint64_t high = aHigh * bHigh, middle0 = aHigh * bLow, middle1 = aLow * bHigh, low = aLow * bLow;
+			uint64_t temp = low + (middle0 << 32);
+			uint64_t carry = temp < low;
+			uint64_t lowResult = temp + (middle1 << 32);
+			carry += lowResult < temp;
+			a = lowResult;
+			b = high + (middle0 >> 32) + (middle1 >> 32) + carry;
+#endif
+		}
+
+		constexpr inline uint64_t Mix(uint64_t a, uint64_t b) noexcept {
+			Mum(a, b);
+			return a ^ b;
+		}
+
+		template<size_t T_size>
+		constexpr inline uint64_t Read(const char* p) noexcept {
+			if (std::is_constant_evaluated()) {
+				uint64_t value = 0;
+				for (size_t i = 0; i < T_size; i++) {
+					value |= (uint64_t)(uint8_t)p[i] << (i * 8);
+				}
+				return value;
+			}
+			std::conditional_t<T_size == 8, uint64_t, uint32_t> value;
+			std::memcpy(&value, p, T_size);
+			return value;
+		}
+
+		// 1 to 3 bytes
+		constexpr inline uint64_t Read3(const char* p, size_t length) noexcept {
+			return ((uint64_t)(uint8_t)p[0] << 16) | ((uint64_t)(uint8_t)p[length >> 1] << 8) | (uint8_t)p[length - 1];
+		}
+
+		constexpr inline uint64_t Hash(const char* p, size_t length, uint64_t seed) noexcept {
+			seed ^= Mix(seed ^ secret[0], secret[1]);
+			uint64_t a, b;
+			if (length <= 16) {
+				if (length >= 4) {
+					size_t offset = (length >> 3) << 2;
+					a = (Read<4>(p) << 32) | Read<4>(p + offset);
+					b = (Read<4>(p + length - 4) << 32) | Read<4>(p + length - 4 - offset);
+				}
+				else if (length) {
+					a = Read3(p, length);
+					b = 0;
+				}
+				else {
+					a = b = 0;
+				}
+			}
+			else {
+				size_t remaining = length;
+				if (remaining > 48) {
+					uint64_t seed1 = seed, seed2 = seed;
+					do {
+						seed = Mix(Read<8>(p) ^ secret[1], Read<8>(p + 8) ^ seed);
+						seed1 = Mix(Read<8>(p + 16) ^ secret[2], Read<8>(p + 24) ^ seed1);
+						seed2 = Mix(Read<8>(p + 32) ^ secret[3], Read<8>(p + 40) ^ seed2);
+						p += 48;
+						remaining -= 48;
+					} while (remaining > 48);
+					seed ^= seed1 ^ seed2;
+				}
+				while (remaining > 16) {
+					seed = Mix(Read<8>(p) ^ secret[1], Read<8>(p + 8) ^ seed);
+					p += 16;
+					remaining -= 16;
+				}
+				a = Read<8>(p + remaining - 16);
+				b = Read<8>(p + remaining - 8);
+			}
+			a ^= secret[1];
+			b ^= seed;
+			Mum(a, b);
+			return Mix(a ^ secret[0] ^ length, b ^ secret[1]);
+		}
+	}
+
+	// 64 bit hash of length bytes
+	inline uint64_t HashBytes(const void* data, size_t length, uint64_t seed = 0) noexcept {
+		return wyhash::Hash(static_cast<const char*>(data), length, seed);
+	}
+
+	// same as HashBytes, but also usable at compile time
+	constexpr inline uint64_t HashString(std::string_view string, uint64_t seed = 0) noexcept {
+		return wyhash::Hash(string.data(), string.length(), seed);
+	}
+
+	// Control bytes of open addressing hash tables: the top bit is set for empty slots,
+	// full slots store the low 7 bits of the hash of their key as a fingerprint.
+	namespace control {
+
+		typedef uint8_t Byte;
+
+		constexpr inline Byte empty = 0x80;
+		constexpr inline uint32_t group_width = 16;
+
+		constexpr inline Byte Fingerprint(uint64_t hash) noexcept {
+			return static_cast<Byte>(hash & 0x7F);
+		}
+
+		constexpr inline uint64_t Home(uint64_t hash) noexcept {
+			return hash >> 7;
+		}
+
+		constexpr inline bool IsFull(Byte byte) noexcept {
+			return !(byte & empty);
+		}
+
+		// group_width consecutive control bytes, loaded with a single unaligned load when SSE2 is available
+		struct Group {
+
+#ifdef SIMPLE_SSE2
+			__m128i bytes;
+
+			inline explicit Group(const Byte* pos) noexcept : bytes(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pos))) {}
+
+			// bit i is set if byte i equals fingerprint
+			inline uint32_t Match(Byte fingerprint) const noexcept {
+				return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(static_cast<char>(fingerprint)))));
+			}
+
+			inline uint32_t MatchEmpty() const noexcept {
+				return static_cast<uint32_t>(_mm_movemask_epi8(bytes));
+			}
+#else
+			Byte bytes[group_width];
+
+			inline explicit Group(const Byte* pos) noexcept {
+				std::memcpy(bytes, pos, group_width);
+			}
+
+			inline uint32_t Match(Byte fingerprint) const noexcept {
+				uint32_t mask = 0;
+				for (uint32_t i = 0; i < group_width; i++) {
+					mask |= static_cast<uint32_t>(bytes[i] == fingerprint) << i;
+				}
+				return mask;
+			}
+
+			inline uint32_t MatchEmpty() const noexcept {
+				uint32_t mask = 0;
+				for (uint32_t i = 0; i < group_width; i++) {
+					mask |= static_cast<uint32_t>(bytes[i] >> 7) << i;
+				}
+				return mask;
+			}
+#endif
+		};
+
+		inline uint32_t LowestBit(uint32_t mask) noexcept {
+			return static_cast<uint32_t>(std::countr_zero(mask));
+		}
+	}
+}
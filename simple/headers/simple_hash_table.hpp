@@ -0,0 +1,674 @@
+#pragma once
+
+#include "simple_allocator.hpp"
+#include "simple_dynamic_array.hpp"
+#include "simple_hash.hpp"
+#include "simple_tuple.hpp"
+#include <assert.h>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+namespace simple {
+
+	enum class MapLayout {
+		// entries live in the table slots themselves
+		Flat = 0,
+		// entries live packed in a simple::DynamicArray and the table slots hold indices into it,
+		// which makes iteration contiguous and erase O(1) by moving the last entry into the hole
+		Dense = 1,
+	};
+
+	// Open addressing table with linear probing behind simple::Map and simple::Set. Every slot has a control byte holding
+	// a 7 bit fingerprint of the key's hash, which is matched group_width slots at a time before any keys are compared.
+	// Erasing shifts the following entries back instead of leaving tombstones, and the table grows once it's 7/8 full, so
+	// inserts never fail. Entry is either the key itself (sets) or a pair whose first member is the key (maps).
+	template<typename Key, typename Entry, typename Hasher, MapLayout T_layout, typename Allocator>
+	class HashTable {
+	public:
+
+		static constexpr inline uint32_t min_capacity = control::group_width;
+		static constexpr inline bool dense = T_layout == MapLayout::Dense;
+
+		// walks the full slots of the table, then the ones of the old table while an incremental rehash is in progress
+		struct FlatIterator {
+
+			FlatIterator(const control::Byte* control, const control::Byte* controlEnd, Entry* slot,
+				const control::Byte* nextControl = nullptr, const control::Byte* nextControlEnd = nullptr, Entry* nextSlot = nullptr) noexcept
+				: _control(control), _controlEnd(controlEnd), _slot(slot),
+					_nextControl(nextControl), _nextControlEnd(nextControlEnd), _nextSlot(nextSlot) {
+				_SkipEmpty();
+			}
+
+			const control::Byte* _control;
+			const control::Byte* _controlEnd;
+			Entry* _slot;
+			const control::Byte* _nextControl;
+			const control::Byte* _nextControlEnd;
+			Entry* _nextSlot;
+
+			inline void operator++() {
+				++_control;
+				++_slot;
+				_SkipEmpty();
+			}
+
+			inline bool operator==(const FlatIterator& other) const {
+				return _control == other._control;
+			}
+
+			inline Entry& operator*() const {
+				return *_slot;
+			}
+
+			inline Entry* operator->() const {
+				return _slot;
+			}
+
+		private:
+
+			inline void _SkipEmpty() {
+				for (;;) {
+					while (_control != _controlEnd && !control::IsFull(*_control)) {
+						++_control;
+						++_slot;
+					}
+					if (_control != _controlEnd || !_nextControl) {
+						return;
+					}
+					_control = _nextControl;
+					_controlEnd = _nextControlEnd;
+					_slot = _nextSlot;
+					_nextControl = nullptr;
+				}
+			}
+		};
+
+		typedef std::conditional_t<dense, Entry*, FlatIterator> Iterator;
+
+		inline HashTable() noexcept : _allocator(), _table(), _oldTable(), _size(0), _oldSize(0), _rehashBudget(0), _rehashCursor(0), _values() {}
+
+		explicit inline HashTable(const Allocator& allocator) noexcept
+			: _allocator(allocator), _table(), _oldTable(), _size(0), _oldSize(0), _rehashBudget(0), _rehashCursor(0), _values(allocator) {}
+
+		inline HashTable(HashTable&& other) noexcept
+			: _allocator(other._allocator), _table(other._table), _oldTable(other._oldTable), _size(other._size), _oldSize(other._oldSize),
+				_rehashBudget(other._rehashBudget), _rehashCursor(other._rehashCursor), _values(std::move(other._values)) {
+			other._table = {};
+			other._oldTable = {};
+			other._size = 0;
+			other._oldSize = 0;
+		}
+
+		// steals the tables of other if the allocators are equal, moves the entries one by one otherwise
+		inline HashTable(HashTable&& other, const Allocator& allocator)
+			: _allocator(allocator), _table(), _oldTable(), _size(0), _oldSize(0), _rehashBudget(0), _rehashCursor(0), _values(allocator) {
+			_MoveFrom(other);
+		}
+
+		inline HashTable(const HashTable& other) : HashTable(other, AllocatorTraits<Allocator>::SelectOnCopy(other._allocator)) {}
+
+		inline HashTable(const HashTable& other, const Allocator& allocator)
+			: _allocator(allocator), _table(), _oldTable(), _size(0), _oldSize(0), _rehashBudget(0), _rehashCursor(0), _values(allocator) {
+			_CopyFrom(other);
+		}
+
+		inline const Allocator& GetAllocator() const noexcept {
+			return _allocator;
+		}
+
+		inline void Reserve(uint32_t capacity) {
+			if constexpr (dense) {
+				_values.Reserve(capacity);
+			}
+			if (capacity <= _MaxLoad(_table.capacity)) {
+				return;
+			}
+			_Rehash(_GrownCapacity(capacity));
+		}
+
+		inline void SetRehashBudget(uint32_t slotsPerOperation) {
+			_rehashBudget = slotsPerOperation;
+			if (!_rehashBudget) {
+				_Step(UINT32_MAX);
+			}
+		}
+
+		inline bool Step(uint32_t budget) {
+			_Step(budget);
+			return !_oldTable.capacity;
+		}
+
+		constexpr inline bool IsRehashing() const noexcept {
+			return _oldTable.capacity;
+		}
+
+		template<typename K>
+		static inline uint64_t HashKey(const K& key) {
+			return HashMix(Hasher()(key));
+		}
+
+		inline Tuple<bool, Entry*> InsertWithHash(const Entry& entry, uint64_t hash) {
+			Location location = _Find(_KeyOf(entry), hash);
+			if (location.slot != no_slot) {
+				return { false, &_EntryAt(location) };
+			}
+			return { true, _ConstructAt(_PrepareInsert(hash), entry) };
+		}
+
+		// constructs an entry from args without looking for its key first, the key must not be in the table yet
+		template<typename... Args>
+		inline Entry* EmplaceWithHash(uint64_t hash, Args&&... args) {
+			return _ConstructAt(_PrepareInsert(hash), std::forward<Args>(args)...);
+		}
+
+		template<typename K>
+		inline bool EraseWithHash(const K& key, uint64_t hash) {
+			return _Erase(_Find(key, hash));
+		}
+
+		inline void Clear() {
+			if constexpr (dense) {
+				_values.EraseRange(_values.begin(), _values.begin() + _values.Size());
+			}
+			else {
+				_DestroyEntries(_table);
+				_DestroyEntries(_oldTable);
+			}
+			_FreeTable(_oldTable);
+			_oldSize = 0;
+			if (_table.capacity) {
+				std::memset(_table.control, control::empty, _table.capacity + control::group_width - 1);
+			}
+			_size = 0;
+		}
+
+		template<typename K>
+		inline Entry* FindWithHash(const K& key, uint64_t hash) const noexcept {
+			Location location = _Find(key, hash);
+			return location.slot != no_slot ? &_EntryAt(location) : nullptr;
+		}
+
+		constexpr inline size_t Size() const noexcept {
+			return _size;
+		}
+
+		constexpr inline uint32_t Capacity() const noexcept {
+			return _table.capacity;
+		}
+
+		inline HashTable& operator=(const HashTable& other) {
+			if (this == &other) {
+				return *this;
+			}
+			Clear();
+			if constexpr (AllocatorTraits<Allocator>::propagate_on_copy) {
+				if (!AllocatorTraits<Allocator>::Equal(_allocator, other._allocator)) {
+					_Destroy();
+					_ResetAllocator(other._allocator);
+				}
+			}
+			_CopyFrom(other);
+			return *this;
+		}
+
+		inline HashTable& operator=(HashTable&& other) noexcept(AllocatorTraits<Allocator>::propagate_on_move || AllocatorTraits<Allocator>::always_equal) {
+			if (this == &other) {
+				return *this;
+			}
+			_Destroy();
+			if constexpr (AllocatorTraits<Allocator>::propagate_on_move) {
+				_ResetAllocator(other._allocator);
+			}
+			_MoveFrom(other);
+			return *this;
+		}
+
+		// allocators that don't propagate on swap must be equal
+		inline void Swap(HashTable& other) noexcept {
+			if constexpr (AllocatorTraits<Allocator>::propagate_on_swap) {
+				std::swap(_allocator, other._allocator);
+			}
+			else {
+				assert(AllocatorTraits<Allocator>::Equal(_allocator, other._allocator)
+					&& "attempting to swap hash tables with unequal allocators (function simple::HashTable::Swap)!");
+			}
+			std::swap(_table, other._table);
+			std::swap(_oldTable, other._oldTable);
+			std::swap(_size, other._size);
+			std::swap(_oldSize, other._oldSize);
+			std::swap(_rehashBudget, other._rehashBudget);
+			std::swap(_rehashCursor, other._rehashCursor);
+			_values.Swap(other._values);
+		}
+
+		inline Iterator begin() const {
+			if constexpr (dense) {
+				return _values.begin();
+			}
+			else {
+				if (_oldTable.capacity) {
+					return FlatIterator(_table.control, _table.control + _table.capacity, _table.slots,
+						_oldTable.control, _oldTable.control + _oldTable.capacity, _oldTable.slots);
+				}
+				return FlatIterator(_table.control, _table.control + _table.capacity, _table.slots);
+			}
+		}
+
+		inline const Iterator end() const {
+			if constexpr (dense) {
+				return (Entry*)_values.end();
+			}
+			else {
+				const Table& last = _oldTable.capacity ? _oldTable : _table;
+				return FlatIterator(last.control + last.capacity, last.control + last.capacity, last.slots + last.capacity);
+			}
+		}
+
+		~HashTable() {
+			_Destroy();
+		}
+
+	private:
+
+		typedef std::conditional_t<dense, uint32_t, Entry> Slot;
+
+		// the control bytes and the index table come from the same allocator as the entries
+		typedef typename AllocatorTraits<Allocator>::template Rebind<control::Byte> ControlAllocator;
+		typedef typename AllocatorTraits<Allocator>::template Rebind<uint32_t> IndexAllocator;
+
+		struct Table {
+			uint32_t capacity{};
+			control::Byte* control{};
+			Slot* slots{};
+		};
+
+		struct Location {
+			uint32_t slot;
+			bool old;
+		};
+
+		static constexpr inline uint32_t no_slot = UINT32_MAX;
+
+		static constexpr inline uint32_t _MaxLoad(uint32_t capacity) noexcept {
+			return capacity - capacity / 8;
+		}
+
+		static inline const Key& _KeyOf(const Entry& entry) noexcept {
+			if constexpr (std::is_same_v<Key, Entry>) {
+				return entry;
+			}
+			else {
+				return entry.first;
+			}
+		}
+
+		static inline uint32_t _Home(const Table& table, uint64_t hash) noexcept {
+			return static_cast<uint32_t>(control::Home(hash)) & (table.capacity - 1);
+		}
+
+		static inline void _SetControl(Table& table, uint32_t slot, control::Byte byte) noexcept {
+			table.control[slot] = byte;
+			// the first bytes are mirrored past the end so that groups can be loaded at any slot without wrapping
+			if (slot < control::group_width - 1) {
+				table.control[table.capacity + slot] = byte;
+			}
+		}
+
+		inline uint32_t _GrownCapacity(uint32_t count) const noexcept {
+			uint32_t capacity = _table.capacity ? _table.capacity : min_capacity;
+			while (count > _MaxLoad(capacity)) {
+				capacity *= 2;
+			}
+			return capacity;
+		}
+
+		inline Entry& _EntryAt(const Table& table, uint32_t slot) const noexcept {
+			if constexpr (dense) {
+				return _values[table.slots[slot]];
+			}
+			else {
+				return table.slots[slot];
+			}
+		}
+
+		inline Entry& _EntryAt(Location location) const noexcept {
+			return _EntryAt(location.old ? _oldTable : _table, location.slot);
+		}
+
+		template<typename... Args>
+		inline Entry* _ConstructAt(uint32_t slot, Args&&... args) {
+			if constexpr (dense) {
+				_table.slots[slot] = _values.Size();
+				return &_values.EmplaceBack(std::forward<Args>(args)...);
+			}
+			else {
+				_allocator.construct(&_table.slots[slot], std::forward<Args>(args)...);
+				return &_table.slots[slot];
+			}
+		}
+
+		inline void _MoveSlot(Table& dst, uint32_t dstSlot, Table& src, uint32_t srcSlot) {
+			if constexpr (dense) {
+				dst.slots[dstSlot] = src.slots[srcSlot];
+			}
+			else {
+				Relocate(_allocator, &dst.slots[dstSlot], &src.slots[srcSlot], 1);
+			}
+		}
+
+		template<typename K>
+		inline uint32_t _FindSlot(const Table& table, const K& key, uint64_t hash) const {
+			if (!table.capacity) {
+				return no_slot;
+			}
+			control::Byte fingerprint = control::Fingerprint(hash);
+			uint32_t mask = table.capacity - 1;
+			uint32_t pos = _Home(table, hash);
+			for (;;) {
+				control::Group group(&table.control[pos]);
+				for (uint32_t match = group.Match(fingerprint); match; match &= match - 1) {
+					uint32_t slot = (pos + control::LowestBit(match)) & mask;
+					if (_KeyOf(_EntryAt(table, slot)) == key) {
+						return slot;
+					}
+				}
+				if (group.MatchEmpty()) {
+					return no_slot;
+				}
+				pos = (pos + control::group_width) & mask;
+			}
+		}
+
+		template<typename K>
+		inline Location _Find(const K& key, uint64_t hash) const {
+			if (!_size) {
+				return { no_slot, false };
+			}
+			uint32_t slot = _FindSlot(_table, key, hash);
+			if (slot == no_slot && _oldSize) {
+				return { _FindSlot(_oldTable, key, hash), true };
+			}
+			return { slot, false };
+		}
+
+		inline bool _Erase(Location location) {
+			if (location.slot == no_slot) {
+				return false;
+			}
+			Table& table = location.old ? _oldTable : _table;
+			if constexpr (dense) {
+				uint32_t index = table.slots[location.slot];
+				uint32_t last = _values.Size() - 1;
+				_ShiftBack(table, location.slot);
+				if (index != last) {
+					_IndexSlot(last) = index;
+				}
+				_values.EraseUnordered(&_values[index]);
+			}
+			else {
+				_allocator.destroy(&table.slots[location.slot]);
+				_ShiftBack(table, location.slot);
+			}
+			_oldSize -= location.old;
+			--_size;
+			_Step(_rehashBudget);
+			return true;
+		}
+
+		// slot of table that holds the given index into _values, only used by the dense layout
+		inline uint32_t _FindIndexSlot(const Table& table, uint32_t index, uint64_t hash) const {
+			if (!table.capacity) {
+				return no_slot;
+			}
+			control::Byte fingerprint = control::Fingerprint(hash);
+			uint32_t mask = table.capacity - 1;
+			uint32_t pos = _Home(table, hash);
+			for (;;) {
+				control::Group group(&table.control[pos]);
+				for (uint32_t match = group.Match(fingerprint); match; match &= match - 1) {
+					uint32_t slot = (pos + control::LowestBit(match)) & mask;
+					if (table.slots[slot] == index) {
+						return slot;
+					}
+				}
+				if (group.MatchEmpty()) {
+					return no_slot;
+				}
+				pos = (pos + control::group_width) & mask;
+			}
+		}
+
+		inline uint32_t& _IndexSlot(uint32_t index) {
+			uint64_t hash = HashKey(_KeyOf(_values[index]));
+			uint32_t slot = _FindIndexSlot(_table, index, hash);
+			if (slot != no_slot) {
+				return _table.slots[slot];
+			}
+			slot = _FindIndexSlot(_oldTable, index, hash);
+			assert(slot != no_slot && "simple::HashTable index table is out of sync with its entries!");
+			return _oldTable.slots[slot];
+		}
+
+		static inline uint32_t _FindEmptySlot(const Table& table, uint64_t hash) noexcept {
+			uint32_t mask = table.capacity - 1;
+			uint32_t pos = _Home(table, hash);
+			for (;;) {
+				uint32_t empty = control::Group(&table.control[pos]).MatchEmpty();
+				if (empty) {
+					return (pos + control::LowestBit(empty)) & mask;
+				}
+				pos = (pos + control::group_width) & mask;
+			}
+		}
+
+		// grows the table if needed and claims an empty slot for hash, the caller constructs the entry
+		inline uint32_t _PrepareInsert(uint64_t hash) {
+			_Step(_rehashBudget);
+			// checked against every entry, including the ones still in the old table, so the migration always fits
+			if (_size + 1 > _MaxLoad(_table.capacity)) {
+				_Grow(_size + 1);
+			}
+			uint32_t slot = _FindEmptySlot(_table, hash);
+			_SetControl(_table, slot, control::Fingerprint(hash));
+			++_size;
+			return slot;
+		}
+
+		inline void _Grow(uint32_t count) {
+			uint32_t newCapacity = _GrownCapacity(count);
+			if (!_rehashBudget || !_size) {
+				_Rehash(newCapacity);
+				return;
+			}
+			// the previous migration has to be finished before its table can become the old table
+			_Step(UINT32_MAX);
+			_oldTable = _table;
+			_oldSize = _size;
+			_rehashCursor = 0;
+			_table = _NewTable(newCapacity);
+			_Step(_rehashBudget);
+		}
+
+		// Moves the entries of the old table starting from slot _rehashCursor. Taking an entry out of the old table shifts the
+		// rest of its probe run back, so a slot is only passed once it's empty, and no entry can be shifted behind the cursor
+		// because every slot before it is already empty.
+		inline void _Step(uint32_t budget) {
+			for (; budget && _oldTable.capacity; --budget) {
+				while (control::IsFull(_oldTable.control[_rehashCursor])) {
+					uint64_t hash = HashKey(_KeyOf(_EntryAt(_oldTable, _rehashCursor)));
+					uint32_t slot = _FindEmptySlot(_table, hash);
+					_SetControl(_table, slot, control::Fingerprint(hash));
+					_MoveSlot(_table, slot, _oldTable, _rehashCursor);
+					_ShiftBack(_oldTable, _rehashCursor);
+					--_oldSize;
+				}
+				if (++_rehashCursor == _oldTable.capacity || !_oldSize) {
+					assert(!_oldSize && "simple::HashTable incremental rehash skipped entries!");
+					_FreeTable(_oldTable);
+				}
+			}
+		}
+
+		// backward shift deletion: moves following entries of the probe run into the hole so lookups never need tombstones
+		inline void _ShiftBack(Table& table, uint32_t hole) {
+			uint32_t mask = table.capacity - 1;
+			uint32_t next = (hole + 1) & mask;
+			while (control::IsFull(table.control[next])) {
+				uint32_t home = _Home(table, HashKey(_KeyOf(_EntryAt(table, next))));
+				if (((next - home) & mask) >= ((next - hole) & mask)) {
+					_MoveSlot(table, hole, table, next);
+					_SetControl(table, hole, table.control[next]);
+					hole = next;
+				}
+				next = (next + 1) & mask;
+			}
+			_SetControl(table, hole, control::empty);
+		}
+
+		inline void _Rehash(uint32_t newCapacity) {
+			_Step(UINT32_MAX);
+			Table oldTable = _table;
+			_table = _NewTable(newCapacity);
+			if constexpr (dense) {
+				// the entries don't move, only the index table is rebuilt
+				for (uint32_t i = 0; i < _values.Size(); i++) {
+					uint64_t hash = HashKey(_KeyOf(_values[i]));
+					uint32_t slot = _FindEmptySlot(_table, hash);
+					_SetControl(_table, slot, control::Fingerprint(hash));
+					_table.slots[slot] = i;
+				}
+			}
+			else {
+				for (uint32_t i = 0; i < oldTable.capacity; i++) {
+					if (!control::IsFull(oldTable.control[i])) {
+						continue;
+					}
+					uint64_t hash = HashKey(_KeyOf(oldTable.slots[i]));
+					uint32_t slot = _FindEmptySlot(_table, hash);
+					_SetControl(_table, slot, control::Fingerprint(hash));
+					_MoveSlot(_table, slot, oldTable, i);
+				}
+			}
+			_FreeTable(oldTable);
+		}
+
+		inline Table _NewTable(uint32_t capacity) {
+			Table table{};
+			table.capacity = capacity;
+			table.control = ControlAllocator(_allocator).allocate(capacity + control::group_width - 1);
+			if constexpr (dense) {
+				table.slots = IndexAllocator(_allocator).allocate(capacity);
+			}
+			else {
+				table.slots = _allocator.allocate(capacity);
+			}
+			assert(table.control && table.slots && "failed to allocate memory!");
+			std::memset(table.control, control::empty, capacity + control::group_width - 1);
+			return table;
+		}
+
+		// frees the memory of the table without destroying its entries
+		inline void _FreeTable(Table& table) {
+			if (!table.capacity) {
+				return;
+			}
+			ControlAllocator(_allocator).deallocate(table.control, table.capacity + control::group_width - 1);
+			if constexpr (dense) {
+				IndexAllocator(_allocator).deallocate(table.slots, table.capacity);
+			}
+			else {
+				_allocator.deallocate(table.slots, table.capacity);
+			}
+			table = {};
+		}
+
+		inline void _DestroyEntries(Table& table) {
+			for (uint32_t i = 0; i < table.capacity; i++) {
+				if (control::IsFull(table.control[i])) {
+					_allocator.destroy(&table.slots[i]);
+				}
+			}
+		}
+
+		inline void _Destroy() {
+			Clear();
+			if constexpr (dense) {
+				_values.Clear();
+			}
+			_FreeTable(_table);
+		}
+
+		// expects the table to be destroyed
+		inline void _ResetAllocator(const Allocator& allocator) {
+			_allocator = allocator;
+			if constexpr (dense) {
+				_values.~DynamicArray();
+				new(&_values) DynamicArray<Entry, Allocator>(allocator);
+			}
+		}
+
+		// expects the table to be empty
+		inline void _CopyFrom(const HashTable& other) {
+			_rehashBudget = other._rehashBudget;
+			if constexpr (dense) {
+				// the entries are copied in order, so only the index table has to be rebuilt
+				_values.AppendRange(other._values.begin(), other._values.end());
+				_size = other._size;
+				if (_size) {
+					_Rehash(_size > _MaxLoad(_table.capacity) ? _GrownCapacity(_size) : _table.capacity);
+				}
+			}
+			else {
+				Reserve(other._size);
+				for (const Entry& entry : other) {
+					_ConstructAt(_PrepareInsert(HashKey(_KeyOf(entry))), entry);
+				}
+			}
+		}
+
+		// expects the table to be destroyed
+		inline void _MoveFrom(HashTable& other) {
+			if (AllocatorTraits<Allocator>::Equal(_allocator, other._allocator)) {
+				_table = other._table;
+				_oldTable = other._oldTable;
+				_size = other._size;
+				_oldSize = other._oldSize;
+				_rehashBudget = other._rehashBudget;
+				_rehashCursor = other._rehashCursor;
+				if constexpr (dense) {
+					_values = std::move(other._values);
+				}
+				other._table = {};
+				other._oldTable = {};
+				other._size = 0;
+				other._oldSize = 0;
+				return;
+			}
+			_rehashBudget = other._rehashBudget;
+			Reserve(other._size);
+			for (Entry& entry : other) {
+				_ConstructAt(_PrepareInsert(HashKey(_KeyOf(entry))), std::move(entry));
+			}
+			other.Clear();
+		}
+
+		struct Empty {
+			constexpr inline Empty() noexcept = default;
+			constexpr inline Empty(const Allocator&) noexcept {}
+			constexpr inline uint32_t Size() const noexcept { return 0; }
+			constexpr inline void Swap(Empty&) noexcept {}
+		};
+
+		Allocator _allocator;
+		Table _table;
+		Table _oldTable;
+		uint32_t _size;
+		// entries still waiting in _oldTable during an incremental rehash
+		uint32_t _oldSize;
+		uint32_t _rehashBudget;
+		uint32_t _rehashCursor;
+		std::conditional_t<dense, DynamicArray<Entry, Allocator>, Empty> _values;
+	};
+}
@@ -0,0 +1,269 @@
+#pragma once
+
+#include "simple_allocator.hpp"
+#include "simple_hash.hpp"
+#include "simple_string_view.hpp"
+#include <assert.h>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <new>
+
+namespace simple {
+
+	class InternPool;
+
+	// Handle to a string stored once in a simple::InternPool. Equal strings interned in the same pool always get the same id,
+	// so comparing and hashing handles only touches the id. The characters stay valid (and null terminated) for the lifetime of the pool.
+	class InternedString {
+	public:
+
+		friend class InternPool;
+
+		// the empty string, shared by every pool
+		constexpr inline InternedString() noexcept : _id(0), _pData("") {}
+
+		// interns string in the global pool
+		explicit inline InternedString(StringView string);
+
+		constexpr inline uint32_t Id() const noexcept {
+			return _id;
+		}
+
+		constexpr inline const char* Data() const noexcept {
+			return _pData;
+		}
+
+		inline uint32_t Length() const noexcept {
+			return _id ? reinterpret_cast<const uint32_t*>(_pData)[-1] : 0;
+		}
+
+		constexpr inline bool Empty() const noexcept {
+			return !_id;
+		}
+
+		inline StringView View() const noexcept {
+			return StringView(_pData, Length());
+		}
+
+		constexpr inline uint64_t hash() const noexcept {
+			return _id;
+		}
+
+		constexpr inline bool operator==(const InternedString& other) const noexcept {
+			return _id == other._id;
+		}
+
+		// orders by id (i.e. by first interning), not alphabetically, compare View() for that
+		constexpr inline bool operator<(const InternedString& other) const noexcept {
+			return _id < other._id;
+		}
+
+		struct Hash {
+
+			constexpr inline size_t operator()(const InternedString& string) const noexcept {
+				return string._id;
+			}
+		};
+
+	private:
+
+		constexpr inline InternedString(uint32_t id, const char* pData) noexcept : _id(id), _pData(pData) {}
+
+		uint32_t _id;
+		const char* _pData;
+	};
+
+	// Thread safe table of unique strings. Interning a string that's already in the pool (the common case) is lock free:
+	// lookups probe an open addressing table of entry pointers that's only ever replaced, never modified in place by a resize,
+	// so readers keep working while another thread grows it. Only inserting new strings takes a lock.
+	// Strings are copied into blocks that are never moved or freed before the pool is destroyed.
+	class InternPool {
+	public:
+
+		static constexpr inline uint32_t block_size = 64 * 1024;
+		static constexpr inline uint32_t initial_capacity = 1024;
+
+		inline InternPool() : _allocator(), _mutex(), _table(nullptr), _blocks(nullptr), _blockUsed(0), _size(0) {
+			_table.store(_NewTable(initial_capacity, nullptr), std::memory_order_relaxed);
+		}
+
+		InternPool(const InternPool&) = delete;
+		InternPool(InternPool&&) = delete;
+
+		inline InternedString Intern(StringView string) {
+			if (string.Empty()) {
+				return InternedString();
+			}
+			assert(string.Length() < UINT32_MAX && "string too long to intern (function simple::InternPool::Intern)!");
+			uint64_t hash = HashBytes(string.Data(), string.Length());
+			if (const Entry* entry = _Find(_table.load(std::memory_order_acquire), string, hash)) {
+				return InternedString(entry->id, entry->Data());
+			}
+			std::lock_guard lock(_mutex);
+			Table* table = _table.load(std::memory_order_relaxed);
+			if (const Entry* entry = _Find(table, string, hash)) {
+				return InternedString(entry->id, entry->Data());
+			}
+			// load factor of at most 1/2 keeps the probe sequences of lock free readers short
+			if ((_size + 1) * 2 > table->capacity) {
+				table = _Grow(table);
+			}
+			Entry* entry = _NewEntry(string, hash, ++_size);
+			uint32_t mask = table->capacity - 1;
+			uint32_t slot = static_cast<uint32_t>(hash) & mask;
+			while (table->slots[slot].load(std::memory_order_relaxed)) {
+				slot = (slot + 1) & mask;
+			}
+			table->slots[slot].store(entry, std::memory_order_release);
+			return InternedString(entry->id, entry->Data());
+		}
+
+		// returns the empty string if string hasn't been interned, never inserts
+		inline InternedString Find(StringView string) const noexcept {
+			if (string.Empty()) {
+				return InternedString();
+			}
+			const Entry* entry = _Find(_table.load(std::memory_order_acquire), string, HashBytes(string.Data(), string.Length()));
+			return entry ? InternedString(entry->id, entry->Data()) : InternedString();
+		}
+
+		// number of interned strings, not counting the empty string
+		inline uint32_t Size() const noexcept {
+			std::lock_guard lock(_mutex);
+			return _size;
+		}
+
+		inline ~InternPool() {
+			Table* table = _table.load(std::memory_order_relaxed);
+			while (table) {
+				Table* previous = table->previous;
+				_allocator.deallocate(reinterpret_cast<char*>(table), _TableBytes(table->capacity));
+				table = previous;
+			}
+			while (_blocks) {
+				Block* next = _blocks->next;
+				_allocator.deallocate(reinterpret_cast<char*>(_blocks), _blocks->size);
+				_blocks = next;
+			}
+		}
+
+	private:
+
+		// the characters directly follow the entry, the length sits right in front of them (see InternedString::Length)
+		struct Entry {
+			uint64_t hash;
+			uint32_t id;
+			uint32_t length;
+
+			inline const char* Data() const noexcept {
+				return reinterpret_cast<const char*>(this + 1);
+			}
+		};
+
+		struct Block {
+			Block* next;
+			size_t size;
+		};
+
+		// replaced tables are kept until the pool is destroyed, since lock free readers may still be probing them
+		struct Table {
+			Table* previous;
+			uint32_t capacity;
+			std::atomic<Entry*>* slots;
+		};
+
+		static inline const Entry* _Find(const Table* table, StringView string, uint64_t hash) noexcept {
+			uint32_t mask = table->capacity - 1;
+			for (uint32_t slot = static_cast<uint32_t>(hash) & mask;; slot = (slot + 1) & mask) {
+				const Entry* entry = table->slots[slot].load(std::memory_order_acquire);
+				if (!entry) {
+					return nullptr;
+				}
+				if (entry->hash == hash && entry->length == string.Length()
+					&& !std::memcmp(entry->Data(), string.Data(), string.Length())) {
+					return entry;
+				}
+			}
+		}
+
+		static constexpr inline size_t _TableBytes(uint32_t capacity) noexcept {
+			return sizeof(Table) + capacity * sizeof(std::atomic<Entry*>);
+		}
+
+		inline Table* _NewTable(uint32_t capacity, Table* previous) {
+			Table* table = reinterpret_cast<Table*>(_allocator.allocate(_TableBytes(capacity)));
+			assert(table && "failed to allocate memory (function simple::InternPool::_NewTable)!");
+			table->previous = previous;
+			table->capacity = capacity;
+			table->slots = reinterpret_cast<std::atomic<Entry*>*>(table + 1);
+			for (uint32_t i = 0; i < capacity; i++) {
+				new (&table->slots[i]) std::atomic<Entry*>(nullptr);
+			}
+			return table;
+		}
+
+		inline Table* _Grow(Table* table) {
+			Table* newTable = _NewTable(table->capacity * 2, table);
+			uint32_t mask = newTable->capacity - 1;
+			for (uint32_t i = 0; i < table->capacity; i++) {
+				Entry* entry = table->slots[i].load(std::memory_order_relaxed);
+				if (!entry) {
+					continue;
+				}
+				uint32_t slot = static_cast<uint32_t>(entry->hash) & mask;
+				while (newTable->slots[slot].load(std::memory_order_relaxed)) {
+					slot = (slot + 1) & mask;
+				}
+				newTable->slots[slot].store(entry, std::memory_order_relaxed);
+			}
+			_table.store(newTable, std::memory_order_release);
+			return newTable;
+		}
+
+		inline Entry* _NewEntry(StringView string, uint64_t hash, uint32_t id) {
+			size_t size = (sizeof(Entry) + string.Length() + 1 + alignof(Entry) - 1) & ~(alignof(Entry) - 1);
+			if (_blockUsed + size > _BlockCapacity()) {
+				size_t blockSize = sizeof(Block) + (size > block_size ? size : block_size);
+				Block* block = reinterpret_cast<Block*>(_allocator.allocate(blockSize));
+				assert(block && "failed to allocate memory (function simple::InternPool::_NewEntry)!");
+				block->next = _blocks;
+				block->size = blockSize;
+				_blocks = block;
+				_blockUsed = 0;
+			}
+			Entry* entry = reinterpret_cast<Entry*>(reinterpret_cast<char*>(_blocks + 1) + _blockUsed);
+			_blockUsed += size;
+			entry->hash = hash;
+			entry->id = id;
+			entry->length = static_cast<uint32_t>(string.Length());
+			char* data = reinterpret_cast<char*>(entry + 1);
+			std::memcpy(data, string.Data(), string.Length());
+			data[string.Length()] = '\0';
+			return entry;
+		}
+
+		inline size_t _BlockCapacity() const noexcept {
+			return _blocks ? _blocks->size - sizeof(Block) : 0;
+		}
+
+		DynamicAllocator<char> _allocator;
+		mutable std::mutex _mutex;
+		std::atomic<Table*> _table;
+		Block* _blocks;
+		size_t _blockUsed;
+		uint32_t _size;
+	};
+
+	inline InternPool& GlobalInternPool() {
+		static InternPool pool{};
+		return pool;
+	}
+
+	inline InternedString Intern(StringView string) {
+		return GlobalInternPool().Intern(string);
+	}
+
+	inline InternedString::InternedString(StringView string) : InternedString(GlobalInternPool().Intern(string)) {}
+}
@@ -1,246 +1,182 @@
 #pragma once
 
 #include "simple_allocator.hpp"
-#include "simple_array.hpp"
-#include "simple_dynamic_array.hpp"
+#include "simple_hash_table.hpp"
 #include "simple_tuple.hpp"
 #include "simple_pair.hpp"
-#include "simple_logging.hpp"
+#include <assert.h>
+#include <cstdint>
+#include <utility>
 
 namespace simple {
 
-	template<typename Key, typename Val, typename Hasher, uint8_t T_max_bucket_size = 4,
-		typename BucketAllocator = DynamicAllocator<Pair<Array<Pair<Key, Val>, T_max_bucket_size>, uint8_t>>>
+	// Open addressing hash map with linear probing on top of simple::HashTable. Every slot has a control byte holding a 7 bit
+	// fingerprint of the key's hash, which is matched group_width slots at a time before any keys are compared. Erasing
+	// shifts the following entries back instead of leaving tombstones, and the table grows once it's 7/8 full, so inserts
+	// never fail.
+	template<typename Key, typename Val, typename Hasher, MapLayout T_layout = MapLayout::Flat,
+		typename Allocator = DynamicAllocator<Pair<Key, Val>>>
 	class Map {
+	private:
+
+		typedef HashTable<Key, Pair<Key, Val>, Hasher, T_layout, Allocator> Table;
+
 	public:
 
 		typedef Pair<Key, Val> KeyValPair;
-		typedef Pair<Array<KeyValPair, T_max_bucket_size>, uint8_t> Bucket;
+		typedef typename Table::FlatIterator FlatIterator;
+		typedef typename Table::Iterator Iterator;
 
-		struct Iterator {
+		static constexpr inline uint32_t min_capacity = Table::min_capacity;
+		static constexpr inline bool dense = Table::dense;
 
-			Iterator(KeyValPair** ptr) {
-				_ptr = ptr;
-			}
+		inline Map() noexcept = default;
 
-			KeyValPair** _ptr;
+		explicit inline Map(const Allocator& allocator) noexcept : _table(allocator) {}
 
-			inline void operator++() {
-				++_ptr;
-			}
+		// steals the tables of other if the allocators are equal, moves the pairs one by one otherwise
+		inline Map(Map&& other, const Allocator& allocator) : _table(std::move(other._table), allocator) {}
 
-			inline void operator--() {
-				return --_ptr;
-			}
+		inline Map(const Map& other, const Allocator& allocator) : _table(other._table, allocator) {}
 
-			inline bool operator==(const Iterator& other) const {
-				return _ptr == other._ptr;
-			}
+		inline const Allocator& GetAllocator() const noexcept {
+			return _table.GetAllocator();
+		}
 
-			inline Iterator& operator=(const Iterator& other) {
-				_ptr = other._ptr;
-				return *this;
-			}
+		inline void Reserve(uint32_t capacity) {
+			_table.Reserve(capacity);
+		}
 
-			inline KeyValPair& operator*() const {
-				return **_ptr;
-			}
-		};
+		// Enables incremental rehashing: when the table has to grow, a new table is allocated next to the old one and each
+		// Insert/Emplace/Erase (or an explicit Step) migrates up to slotsPerOperation slots of the old table into it, lookups
+		// consult both tables until the migration is done. 0, the default, rebuilds the whole table at once.
+		inline void SetRehashBudget(uint32_t slotsPerOperation) {
+			_table.SetRehashBudget(slotsPerOperation);
+		}
 
-		inline Map() : _capacity(0), _buckets(nullptr), _elements() {
+		// migrates up to budget slots of an incremental rehash, returns true once no rehash is in progress
+		inline bool Step(uint32_t budget) {
+			return _table.Step(budget);
 		}
 
-		inline Map(Map&& other) noexcept 
-			: _allocator(), _capacity(other._capacity), _buckets(other._buckets), _elements(std::move(other._elements)) {
-			other._capacity = 0;
-			other._buckets = nullptr;
+		constexpr inline bool IsRehashing() const noexcept {
+			return _table.IsRehashing();
 		}
 
-		inline Map(const Map& other) noexcept : _allocator(), _capacity(other._capacity), _buckets(nullptr), _elements() {
-			_buckets = _allocator.allocate(_capacity);
-			_elements.reserve(_capacity);
-			for (size_t i = 0; i < _capacity; i++) {
-				_allocator.construct(&_buckets[i]);
-				for (size_t j = 0; j < other._buckets[i].second; j++) {
-					new(&_buckets[i].first[j]) KeyValPair(other._buckets[i].first[j]);
-					_buckets[i].second++;
-					_elements.pushBack(&_buckets[i].first[j]);
-				};
-			}
+		// hash of key as used by the table, can be passed to the WithHash functions so a key is only hashed once
+		static inline uint64_t HashKey(const Key& key) {
+			return Table::HashKey(key);
 		}
 
-		inline void Reserve(uint32_t capacity) {
-			if (capacity <= _capacity) {
-				return;
-			}
-			uint32_t oldCapacity = _capacity;
-			_capacity = _capacity ? _capacity : 1;
-			while (capacity > _capacity) {
-				_capacity *= 2;
-			}
-			Bucket* temp = _buckets;
-			_buckets = _allocator.allocate(_capacity);
-			for (size_t i = 0; i < _capacity; i++) {
-				_allocator.construct(&_buckets[i]);
-			}
-			_elements.Clear();
-			_elements.Reserve(_capacity);
-			for (size_t i = 0; i < oldCapacity; i++) {
-				for (size_t j = 0; j < temp[i].second; j++) {
-					KeyValPair* pair = Emplace(std::move(temp[i].first[j].first)).second;
-					new(&pair->second) Val(std::move(temp[i].first[j].second));
-				}
-			}
-			_allocator.deallocate(temp, 1);
+		template<typename Other> requires TransparentLookup<Hasher, Key, Other>
+		static inline uint64_t HashKey(const Other& key) {
+			return Table::HashKey(key);
 		}
 
 		inline Tuple<bool, KeyValPair*> Insert(const KeyValPair& pair) {
-			uint64_t hash = Hasher()(pair.first);
-			auto& bucket = _buckets[hash % _capacity];
-			if (bucket.second) {
-				for (KeyValPair& element : bucket.first) {
-					if (element.first == pair.first) {
-						return { false, &element };
-					}
-				}
-				logWarning(this, "bad hash (function simple::Map::Insert)!");
-				if (bucket.second >= T_max_bucket_size - 1) {
-					return { false, nullptr };
-				}
-			}
-			if (!_capacity || (float)Size() / _capacity >= 0.8f) {
-				Reserve(_capacity ? _capacity * 2 : 128);
-			}
-			new(&bucket.first[bucket.second]) KeyValPair();
-			bucket.first[bucket.second].first = pair.first;
-			bucket.first[bucket.second].second = pair.second;
-			_elements.pushBack(&bucket.first[bucket.second]);
-			return { true, &bucket.first[bucket.second++] };
+			return _table.InsertWithHash(pair, HashKey(pair.first));
 		}
 
+		// hash must be HashKey(pair.first)
+		inline Tuple<bool, KeyValPair*> InsertWithHash(const KeyValPair& pair, uint64_t hash) {
+			assert(hash == HashKey(pair.first) && "invalid hash (function simple::Map::InsertWithHash)!");
+			return _table.InsertWithHash(pair, hash);
+		}
+
+		// constructs the key from args, the value is default constructed
 		template<typename... Args>
 		inline Tuple<bool, KeyValPair*> Emplace(Args&&... args) {
 			Key key(std::forward<Args>(args)...);
-			uint64_t hash = Hasher()(key);
-			auto& bucket = _buckets[hash % _capacity];
-			if (bucket.second) {
-				for (const KeyValPair& element : bucket.first) {
-					if (element.first == key) {
-						return { false, nullptr };
-					}
-				}
-				logWarning(this, "bad hash (function simple::Map::Emplace)!");
-				if (bucket.second >= 3) {
-					return { false, nullptr };
-				}
-			}
-			if (!_capacity || (float)Size() / _capacity >= 0.8f) {
-				Reserve(_capacity ? _capacity * 2 : 128);
+			uint64_t hash = HashKey(key);
+			if (KeyValPair* pair = _table.FindWithHash(key, hash)) {
+				return { false, pair };
 			}
-			new(&bucket.first[bucket.second]) KeyValPair();
-			new(&bucket.first[bucket.second].first) Key(std::move(key));
-			_elements.PushBack(&bucket.first[bucket.second]);
-			return { true, &bucket.first[bucket.second++] };
+			return { true, _table.EmplaceWithHash(hash, std::move(key), Val()) };
+		}
+
+		inline bool Erase(const Key& key) {
+			return _table.EraseWithHash(key, HashKey(key));
+		}
+
+		template<typename Other> requires TransparentLookup<Hasher, Key, Other>
+		inline bool Erase(const Other& key) {
+			return _table.EraseWithHash(key, HashKey(key));
+		}
+
+		// hash must be HashKey(key)
+		inline bool EraseWithHash(const Key& key, uint64_t hash) {
+			assert(hash == HashKey(key) && "invalid hash (function simple::Map::EraseWithHash)!");
+			return _table.EraseWithHash(key, hash);
+		}
+
+		// destroys every pair but keeps the allocated memory for reuse
+		inline void Clear() {
+			_table.Clear();
 		}
 
 		inline bool Contains(const Key& key) const noexcept {
-			if (!_buckets) {
-				return false;
-			}
-			uint64_t hash = Hasher()(key);
-			auto& bucket = _buckets[hash % _capacity];
-			if (bucket.second == 0) {
-				return false;
-			}
-			for (const KeyValPair& element : bucket.first) {
-				if (element.first == key) {
-					return true;
-				}
-			}
-			return false;
+			return _table.FindWithHash(key, HashKey(key));
+		}
+
+		template<typename Other> requires TransparentLookup<Hasher, Key, Other>
+		inline bool Contains(const Other& key) const noexcept {
+			return _table.FindWithHash(key, HashKey(key));
 		}
 
 		inline KeyValPair* Find(const Key& key) const noexcept {
-			if (!_buckets) {
-				return nullptr;
-			}
-			uint64_t hash = Hasher()(key);
-			auto& bucket = _buckets[hash % _capacity];
-			if (bucket.second == 0) {
-				return nullptr;
-			}
-			for (KeyValPair& element : bucket.first) {
-				if (element.first == key) {
-					return &element;
-				}
-			}
-			return nullptr;
+			return _table.FindWithHash(key, HashKey(key));
+		}
+
+		template<typename Other> requires TransparentLookup<Hasher, Key, Other>
+		inline KeyValPair* Find(const Other& key) const noexcept {
+			return _table.FindWithHash(key, HashKey(key));
+		}
+
+		// hash must be HashKey(key)
+		inline KeyValPair* FindWithHash(const Key& key, uint64_t hash) const noexcept {
+			return _table.FindWithHash(key, hash);
+		}
+
+		template<typename Other> requires TransparentLookup<Hasher, Key, Other>
+		inline KeyValPair* FindWithHash(const Other& key, uint64_t hash) const noexcept {
+			return _table.FindWithHash(key, hash);
 		}
 
 		constexpr inline size_t Size() const noexcept {
-			return _elements.Size();
+			return _table.Size();
+		}
+
+		constexpr inline uint32_t Capacity() const noexcept {
+			return _table.Capacity();
 		}
 
 		inline Val* operator[](const Key& key) {
-			if (!_buckets) {
-				Reserve(128);
+			uint64_t hash = HashKey(key);
+			KeyValPair* pair = _table.FindWithHash(key, hash);
+			if (!pair) {
+				pair = _table.EmplaceWithHash(hash, Key(key), Val());
 			}
-			uint64_t hash = Hasher()(key);
-			auto& bucket = _buckets[hash % _capacity];
-			if (bucket.second) {
-				for (KeyValPair& element : bucket.first) {
-					if (element.first == key) {
-						return &element.second;
-					}
-				}
-				logWarning(this, "bad hash (simple::Map::operator[])!");
-				if (bucket.second >= T_max_bucket_size - 1) {
-					return nullptr;
-				}
-			}
-			if ((float)Size() / _capacity > 0.8f) {
-				Reserve(_capacity * 2);
-			}
-			new(&bucket.first[bucket.second]) KeyValPair();
-			bucket.first[bucket.second].first = key;
-			_elements.PushBack(&bucket.first[bucket.second]);
-			return &bucket.first[bucket.second++].second;
-		}
-
-		inline Map& operator=(const Map& other) {
-			_capacity = other._capacity;
-			_buckets = _allocator.allocate(_capacity);
-			_elements.reserve(_capacity);
-			for (size_t i = 0; i < _capacity; i++) {
-				_allocator.construct(&_buckets[i]);
-				for (size_t j = 0; j < other._buckets[i].second; j++) {
-					new(&_buckets[i].first[j]) KeyValPair(other._buckets[i].first[j]);
-					_elements.pushBack(&_buckets[i].first[j]);
-				};
-			}
-			return *this;
+			return &pair->second;
 		}
 
-		inline Iterator begin() {
-			return _elements.begin();
+		// allocators that don't propagate on swap must be equal
+		inline void Swap(Map& other) noexcept {
+			_table.Swap(other._table);
 		}
 
-		inline const Iterator end() {
-			return (KeyValPair**)_elements.end();
+		inline Iterator begin() const {
+			return _table.begin();
 		}
 
-		~Map() {
-			for (KeyValPair& element : *this) {
-				(&element)->~KeyValPair();
-			}
-			_allocator.deallocate(_buckets, 1);
-			_buckets = nullptr;
+		inline const Iterator end() const {
+			return _table.end();
 		}
 
 	private:
-		BucketAllocator _allocator;
-		uint32_t _capacity;
-		Bucket* _buckets;
-		simple::DynamicArray<KeyValPair*> _elements;
+
+		Table _table;
 	};
+
+	template<typename Key, typename Val, typename Hasher, typename Allocator = DynamicAllocator<Pair<Key, Val>>>
+	using DenseMap = Map<Key, Val, Hasher, MapLayout::Dense, Allocator>;
 }
@@ -0,0 +1,269 @@
+#pragma once
+
+#include "simple_allocator.hpp"
+#include <assert.h>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace simple {
+
+	// Process wide pools of fixed size cells for small allocations, one pool per power of two size class.
+	// Every thread allocates from and frees to its own cache without any synchronization. Caches exchange whole chains of
+	// cells with the shared pool through lock free stacks: a thread with too many free cells pushes a chain, a thread that
+	// ran out pops one (or carves a new chunk). Popping takes the whole stack with one exchange and pushes back the rest,
+	// so a chain can't be freed and reused under a concurrent pop (the ABA problem of a compare exchange pop).
+	// Chunks are never returned to the system, the memory stays available to the pools for the lifetime of the process.
+	class PoolHeap {
+	public:
+
+		static constexpr inline size_t min_cell_size = 16;
+		static constexpr inline size_t max_cell_size = 1024;
+		static constexpr inline size_t cell_alignment = 16;
+		static constexpr inline size_t chunk_size = 64 * 1024;
+		static constexpr inline uint32_t class_count = std::countr_zero(max_cell_size / min_cell_size) + 1;
+
+		PoolHeap() = delete;
+
+		static constexpr inline uint32_t SizeClass(size_t size) noexcept {
+			return size <= min_cell_size ? 0 : std::bit_width(size - 1) - std::countr_zero(min_cell_size);
+		}
+
+		static constexpr inline size_t CellSize(uint32_t sizeClass) noexcept {
+			return min_cell_size << sizeClass;
+		}
+
+		static inline void* Allocate(uint32_t sizeClass) {
+			assert(sizeClass < class_count && "invalid size class (function simple::PoolHeap::Allocate)!");
+			ThreadCache& cache = _cache;
+			Cell* cell = cache.free[sizeClass];
+			if (!cell) {
+				cell = _Refill(cache, sizeClass);
+			}
+			cache.free[sizeClass] = cell->next;
+			cache.count[sizeClass]--;
+			return cell;
+		}
+
+		static inline void Deallocate(void* ptr, uint32_t sizeClass) noexcept {
+			assert(sizeClass < class_count && "invalid size class (function simple::PoolHeap::Deallocate)!");
+			ThreadCache& cache = _cache;
+			Cell* cell = static_cast<Cell*>(ptr);
+			cell->next = cache.free[sizeClass];
+			cache.free[sizeClass] = cell;
+			if (++cache.count[sizeClass] > 2 * _BatchSize(sizeClass)) {
+				_Flush(cache, sizeClass, _BatchSize(sizeClass));
+			}
+		}
+
+	private:
+
+		struct Cell {
+			Cell* next;
+			// only used by the first cell of a chain in the shared stack
+			Cell* nextChain;
+		};
+
+		struct Chunk {
+			Chunk* next;
+		};
+
+		// trivially destructible, so cells freed by destructors that run after the thread's Releaser are still accepted
+		struct ThreadCache {
+			Cell* free[class_count];
+			uint32_t count[class_count];
+		};
+
+		// hands every cached cell back to the shared pool when the thread exits
+		struct Releaser {
+			bool registered;
+
+			inline ~Releaser() {
+				ThreadCache& cache = _cache;
+				for (uint32_t i = 0; i < class_count; i++) {
+					while (cache.count[i]) {
+						_Flush(cache, i, cache.count[i] < _BatchSize(i) ? cache.count[i] : _BatchSize(i));
+					}
+				}
+			}
+		};
+
+		// number of cells moved between a thread cache and the shared pool at once, about 8 KiB worth of cells
+		static constexpr inline uint32_t _BatchSize(uint32_t sizeClass) noexcept {
+			return static_cast<uint32_t>(8192 / CellSize(sizeClass));
+		}
+
+		static inline void _PushChains(uint32_t sizeClass, Cell* first, Cell* last) noexcept {
+			std::atomic<Cell*>& head = *_chains[sizeClass];
+			Cell* current = head.load(std::memory_order_relaxed);
+			do {
+				last->nextChain = current;
+			} while (!head.compare_exchange_weak(current, first, std::memory_order_release, std::memory_order_relaxed));
+		}
+
+		static inline Cell* _PopChain(uint32_t sizeClass) noexcept {
+			Cell* chains = _chains[sizeClass]->exchange(nullptr, std::memory_order_acquire);
+			if (!chains) {
+				return nullptr;
+			}
+			if (Cell* rest = chains->nextChain) {
+				Cell* last = rest;
+				while (last->nextChain) {
+					last = last->nextChain;
+				}
+				_PushChains(sizeClass, rest, last);
+			}
+			return chains;
+		}
+
+		// moves count cells from the front of the cache to the shared pool
+		static inline void _Flush(ThreadCache& cache, uint32_t sizeClass, uint32_t count) noexcept {
+			Cell* first = cache.free[sizeClass];
+			Cell* last = first;
+			for (uint32_t i = 1; i < count; i++) {
+				last = last->next;
+			}
+			cache.free[sizeClass] = last->next;
+			cache.count[sizeClass] -= count;
+			last->next = nullptr;
+			_PushChains(sizeClass, first, first);
+		}
+
+		static inline Cell* _Refill(ThreadCache& cache, uint32_t sizeClass) {
+			// first use of the releaser on this thread registers its destructor
+			_releaser.registered = true;
+			Cell* chain = _PopChain(sizeClass);
+			if (!chain) {
+				chain = _NewChunk(sizeClass);
+			}
+			uint32_t count = 0;
+			for (Cell* cell = chain; cell; cell = cell->next) {
+				count++;
+			}
+			cache.count[sizeClass] += count;
+			return chain;
+		}
+
+		// carves a chunk into chains of one batch, keeps the first one and shares the rest
+		static inline Cell* _NewChunk(uint32_t sizeClass) {
+			char* memory = static_cast<char*>(std::malloc(chunk_size));
+			assert(memory && "failed to allocate memory (function simple::PoolHeap::Allocate)!");
+			Chunk* chunk = reinterpret_cast<Chunk*>(memory);
+			chunk->next = _chunks.load(std::memory_order_relaxed);
+			while (!_chunks.compare_exchange_weak(chunk->next, chunk, std::memory_order_relaxed)) {}
+			size_t cellSize = CellSize(sizeClass);
+			uint32_t batchSize = _BatchSize(sizeClass);
+			char* begin = memory + cell_alignment;
+			uint32_t cellCount = static_cast<uint32_t>((chunk_size - cell_alignment) / cellSize);
+			Cell* first = nullptr;
+			for (uint32_t i = 0; i < cellCount; i += batchSize) {
+				uint32_t end = i + batchSize < cellCount ? i + batchSize : cellCount;
+				for (uint32_t j = i; j < end; j++) {
+					reinterpret_cast<Cell*>(begin + j * cellSize)->next = j + 1 < end ? reinterpret_cast<Cell*>(begin + (j + 1) * cellSize) : nullptr;
+				}
+				Cell* chain = reinterpret_cast<Cell*>(begin + i * cellSize);
+				if (first) {
+					_PushChains(sizeClass, chain, chain);
+				}
+				else {
+					first = chain;
+				}
+			}
+			return first;
+		}
+
+		// each on its own cache line, threads freeing different sizes shouldn't contend
+		static inline CachePadded<std::atomic<Cell*>> _chains[class_count]{};
+		// keeps the chunks reachable, they're never freed
+		static inline std::atomic<Chunk*> _chunks{};
+		static inline thread_local ThreadCache _cache{};
+		static inline thread_local Releaser _releaser;
+	};
+
+	// Allocator for containers and nodes that are created and destroyed often. Allocations of up to PoolHeap::max_cell_size bytes
+	// come from the thread local pools of simple::PoolHeap, larger ones (and over aligned types) go to the system heap.
+	// Relies on deallocate receiving the same size that was allocated.
+	template<typename T>
+	class PoolAllocator {
+	public:
+
+		inline PoolAllocator() = default;
+
+		constexpr inline PoolAllocator(const PoolAllocator&) noexcept {}
+
+		template<typename U>
+		constexpr inline PoolAllocator(const PoolAllocator<U>&) noexcept {}
+
+		inline T* allocate(size_t size) {
+			if (_Pooled(size)) {
+				return static_cast<T*>(PoolHeap::Allocate(PoolHeap::SizeClass(size * sizeof(T))));
+			}
+			return static_cast<T*>(AlignedAllocate(size * sizeof(T), alignof(T)));
+		}
+
+		// only valid for trivially relocatable types, since the bytes are moved without calling any constructors
+		inline T* reallocate(T* ptr, size_t oldSize, size_t newSize) {
+			static_assert(trivially_relocatable<T>, "attempting to reallocate memory of a type that's not trivially relocatable (function simple::PoolAllocator::reallocate)!");
+			if (!ptr) {
+				return allocate(newSize);
+			}
+			bool oldPooled = _Pooled(oldSize);
+			bool newPooled = _Pooled(newSize);
+			if (!oldPooled && !newPooled) {
+				return static_cast<T*>(AlignedReallocate(ptr, oldSize * sizeof(T), newSize * sizeof(T), alignof(T)));
+			}
+			if (oldPooled && newPooled && PoolHeap::SizeClass(oldSize * sizeof(T)) == PoolHeap::SizeClass(newSize * sizeof(T))) {
+				return ptr;
+			}
+			T* result = allocate(newSize);
+			if (result) {
+				std::memcpy((void*)result, (const void*)ptr, (oldSize < newSize ? oldSize : newSize) * sizeof(T));
+				deallocate(ptr, oldSize);
+			}
+			return result;
+		}
+
+		inline void deallocate(T* ptr, size_t size) noexcept {
+			if (!ptr) {
+				return;
+			}
+			if (_Pooled(size)) {
+				PoolHeap::Deallocate(ptr, PoolHeap::SizeClass(size * sizeof(T)));
+				return;
+			}
+			AlignedDeallocate(ptr, alignof(T));
+		}
+
+		template<typename... Args>
+		inline void construct(T* ptr, Args&&... args) {
+			new(ptr) T(std::forward<Args>(args)...);
+		}
+
+		inline void destroy(T* ptr) noexcept {
+			ptr->~T();
+		}
+
+		friend bool operator==(const PoolAllocator&, const PoolAllocator&) {
+			return true;
+		}
+
+		friend bool operator!=(const PoolAllocator&, const PoolAllocator&) {
+			return false;
+		}
+
+	private:
+
+		static constexpr inline bool _Pooled(size_t size) noexcept {
+			return size && size * sizeof(T) <= PoolHeap::max_cell_size && alignof(T) <= PoolHeap::cell_alignment;
+		}
+	};
+
+	template<typename T>
+	struct TriviallyRelocatable<PoolAllocator<T>> {
+		static constexpr inline bool value = true;
+	};
+}
@@ -1,247 +1,157 @@
 #pragma once
 
 #include "simple_allocator.hpp"
-#include "simple_array.hpp"
-#include "simple_dynamic_array.hpp"
-#include "simple_pair.hpp"
+#include "simple_hash_table.hpp"
 #include "simple_tuple.hpp"
-#include "simple_logging.hpp"
+#include <assert.h>
 #include <cstdint>
 #include <utility>
 
 namespace simple {
 
-	template<typename T, typename Hasher, uint8_t T_max_bucket_size = 4,
-		typename Allocator = DynamicAllocator<Pair<Array<Pair<T, bool>, T_max_bucket_size>, uint8_t>>>
+	// Open addressing hash set on the same dense simple::HashTable as simple::DenseMap. The elements are kept densely packed
+	// in a simple::DynamicArray and the table stores indices into it, so iteration is contiguous and Erase is O(1):
+	// the last element is moved into the hole and the one index pointing at it is patched, no tombstones are left behind.
+	// Pointers to elements are only valid until the next Insert/Emplace/Erase.
+	template<typename T, typename Hasher, typename Allocator = DynamicAllocator<T>>
 	class Set {
-	public:
+	private:
 
-		typedef size_t HashType;
-		typedef uint8_t BucketSize;
-		typedef Pair<T, bool> Element;
-		typedef Pair<Array<Element, T_max_bucket_size>, BucketSize> Bucket;
+		typedef HashTable<T, T, Hasher, MapLayout::Dense, Allocator> Table;
 
-		struct Iterator {	
+	public:
 
-			Element** _ptr;
-			simple::DynamicArray<Element*>& _parent;
+		typedef T* Iterator;
+		typedef const T* ConstIterator;
 
-			Iterator(Element** ptr, simple::DynamicArray<Element*>& parent) noexcept 
-				: _ptr(ptr), _parent(parent) {
-			}
+		static constexpr inline uint32_t min_capacity = Table::min_capacity;
 
-			inline void operator++() {
-				++_ptr;
-				while (_ptr != _parent.end() && !(**_ptr).second) {
-					++_ptr;
-				}
-			}
+		inline Set() noexcept = default;
 
-			inline void operator--() {
-				--_ptr;
-				while (!_ptr->second && _ptr != _parent.begin()) {
-					--_ptr;
-				}
-			}
+		explicit inline Set(const Allocator& allocator) noexcept : _table(allocator) {}
 
-			inline bool operator==(const Iterator& other) const {
-				return _ptr == other._ptr;
-			}
+		// steals the tables of other if the allocators are equal, moves the elements one by one otherwise
+		inline Set(Set&& other, const Allocator& allocator) : _table(std::move(other._table), allocator) {}
 
-			inline Iterator& operator=(const Iterator& other) {
-				_ptr = other._ptr;size_t
-				_parent = other._parent;
-				return *this;
-			}
+		inline Set(const Set& other, const Allocator& allocator) : _table(other._table, allocator) {}
 
-			inline T& operator*() const {
-				return (*_ptr)->first;
-			}
-		};
+		inline const Allocator& GetAllocator() const noexcept {
+			return _table.GetAllocator();
+		}
+
+		inline void Reserve(uint32_t capacity) {
+			_table.Reserve(capacity);
+		}
 
-		typedef const Iterator ConstIterator;
+		// Enables incremental rehashing, see simple::Map::SetRehashBudget. 0, the default, rebuilds the whole table at once.
+		inline void SetRehashBudget(uint32_t slotsPerOperation) {
+			_table.SetRehashBudget(slotsPerOperation);
+		}
 
-		inline Set() : _capacity(128), _buckets(nullptr), _elements(), _trash(0) {
-			_buckets = Allocator().allocate(_capacity);
-			for (size_t i = 0; i < _capacity; i++) {
-				Allocator().construct(&_buckets[i]);
-			}
-			_elements.Reserve(_capacity);
+		// migrates up to budget slots of an incremental rehash, returns true once no rehash is in progress
+		inline bool Step(uint32_t budget) {
+			return _table.Step(budget);
 		}
 
-		inline Set(Set&& other) noexcept
-			: _capacity(other._capacity), _buckets(other._buckets), _elements(std::move(other._elements)), 
-			_trash(other._trash)  {
-			other._capacity = 0;
-			other._buckets = nullptr;
+		constexpr inline bool IsRehashing() const noexcept {
+			return _table.IsRehashing();
 		}
 
-		void Cleanup() {
-			for (auto iter = _elements.begin(); iter != _elements.end();) {
-				if (!(*iter)->second) {
-					iter = _elements.Erase(iter);
-					continue;
-				}
-				++iter;
-			}
-			_trash = 0;
+		// hash of value as used by the table, can be passed to the WithHash functions so a value is only hashed once
+		static inline uint64_t HashKey(const T& value) {
+			return Table::HashKey(value);
 		}
 
-		inline void Reserve(uint32_t capacity) {
-			if (capacity <= _capacity) {
-				return;
-			}
-			uint32_t oldCapacity = _capacity;
-			while (capacity > _capacity) {
-				_capacity *= 2;
-			}
-			Bucket* temp = _buckets;
-			_buckets = Allocator().allocate(_capacity);
-			for (uint32_t i = 0; i < _capacity; i++) {
-				Allocator().construct(&_buckets[i]);
-			}
-			_elements.Clear();
-			_elements.Reserve(_capacity);
-			for (uint32_t i = 0; i < oldCapacity; i++) {
-				for (BucketSize j = 0; j < temp[i].second; j++) {
-					Emplace(std::move(temp[i].first[j].first));
-				}
-			}
-			Allocator().deallocate(temp, 1);
+		template<typename Other> requires TransparentLookup<Hasher, T, Other>
+		static inline uint64_t HashKey(const Other& value) {
+			return Table::HashKey(value);
 		}
 
 		inline Tuple<bool, T*> Insert(const T& value) {
-			HashType hash = Hasher()(value);
-			auto& bucket = _buckets[hash % _capacity];
-			if (bucket.second) {
-				for (const Element& element : bucket.first) {
-					if (element.first == value) {
-						return { false, nullptr };
-					}
-				}
-				simple::logMessage(this, "bad hash (function simple::Set::Insert)!");
-				if (bucket.second >= T_max_bucket_size - 1) {
-					return { false, nullptr };
-				}
-			}
-			bucket.first[bucket.second].first = value;
-			bucket.first[bucket.second].second = true;
-			if ((float)_elements.Size() / _capacity >= 0.8f) {
-				Reserve(_capacity * 2);
-			}
-			Element* element = _elements.PushBack(&bucket.first[bucket.second++]);
-			return { true, &element->first } ;
+			return _table.InsertWithHash(value, HashKey(value));
+		}
+
+		// hash must be HashKey(value)
+		inline Tuple<bool, T*> InsertWithHash(const T& value, uint64_t hash) {
+			assert(hash == HashKey(value) && "invalid hash (function simple::Set::InsertWithHash)!");
+			return _table.InsertWithHash(value, hash);
 		}
 
 		template<typename... Args>
 		inline Tuple<bool, T*> Emplace(Args&&... args) {
 			T value(std::forward<Args>(args)...);
-			HashType hash = Hasher()(value);
-			Bucket& bucket = _buckets[hash % _capacity];
-			if (bucket.second) {
-				for (const Element& element : bucket.first) {
-					if (element.first == value) {
-						return { false, nullptr };
-					}
-				}
-				simple::logMessage(this, "bad hash (function simple::Set::Emplace)!");
-				if (bucket.second >= T_max_bucket_size - 1) {
-					return { false, nullptr };
-				}
-			}
-			new(&bucket.first[bucket.second].first) T(std::move(value));
-			bucket.first[bucket.second].second = true;
-			_elements.PushBack(&bucket.first[bucket.second]);
-			if ((float)_elements.Size() / _capacity >= 0.8f) {
-				Reserve(_capacity * 2);
+			uint64_t hash = HashKey(value);
+			if (T* element = _table.FindWithHash(value, hash)) {
+				return { false, element };
 			}
-			return { true, &bucket.first[bucket.second++].first };
+			return { true, _table.EmplaceWithHash(hash, std::move(value)) };
 		}
 
 		inline bool Erase(const T& value) {
-			if (_trash > 8) {
-				Cleanup();
-			}
-			HashType hash = Hasher()(value);
-			auto& bucket = _buckets[hash % _capacity];
-			if (bucket.second) {
-				for (Element& element : bucket.first) {
-					if (element.first == value) {
-						&element.first->~T();
-						element.second = false;
-						bucket.second--;
-						_trash++;
-						return true;
-					}
-				}
-			}
-			return false;
+			return _table.EraseWithHash(value, HashKey(value));
 		}
 
-		inline bool Contains(const T& value) {
-			HashType hash = Hasher()(value);
-			auto& bucket = _buckets[hash % _capacity];
-			if (bucket.second == 0) {
-				return false;
-			}
-			for (const Element& element : bucket.first) {
-				if (element.first == value) {
-					return true;
-				}
-			}
-			return false;
+		template<typename Other> requires TransparentLookup<Hasher, T, Other>
+		inline bool Erase(const Other& value) {
+			return _table.EraseWithHash(value, HashKey(value));
 		}
 
-		inline const Bucket* GetBucket(HashType hash) {
-			return &_buckets[hash % _capacity];
+		// destroys every element but keeps the allocated memory for reuse
+		inline void Clear() {
+			_table.Clear();
 		}
 
-		inline const T* Find(const T& value) {
-			HashType hash = Hasher()(value);
-			auto& bucket = _buckets[hash % _capacity];
-			if (bucket.second == 0) {
-				return nullptr;
-			}
-			for (const T& element : bucket.first) {
-				if (element == value) {
-					return &element;
-				}
-			}
-			return nullptr;
+		inline bool Contains(const T& value) const {
+			return _table.FindWithHash(value, HashKey(value));
 		}
 
-		size_t Size() {
-			return _elements.size() - _trash;
+		template<typename Other> requires TransparentLookup<Hasher, T, Other>
+		inline bool Contains(const Other& value) const {
+			return _table.FindWithHash(value, HashKey(value));
 		}
 
-		inline Iterator begin() {
-			Element** ptr = _elements.begin();
-			if (!ptr || !_elements.Size()) {
-				return Iterator(ptr, _elements);
-			}
-			while (ptr != _elements.end() && !(*ptr)->second) {
-				++ptr;
-			}
-			return Iterator(ptr, _elements);
+		inline const T* Find(const T& value) const {
+			return _table.FindWithHash(value, HashKey(value));
 		}
 
-		inline ConstIterator end() {
-			return Iterator((Element**)_elements.end(), _elements);
+		template<typename Other> requires TransparentLookup<Hasher, T, Other>
+		inline const T* Find(const Other& value) const {
+			return _table.FindWithHash(value, HashKey(value));
 		}
 
-		~Set() {
-			for (T& value : *this) {
-				(&value)->~T();
-			}
-			Allocator().deallocate(_buckets, 1);
-			_buckets = nullptr;
+		// hash must be HashKey(value)
+		inline const T* FindWithHash(const T& value, uint64_t hash) const {
+			return _table.FindWithHash(value, hash);
+		}
+
+		template<typename Other> requires TransparentLookup<Hasher, T, Other>
+		inline const T* FindWithHash(const Other& value, uint64_t hash) const {
+			return _table.FindWithHash(value, hash);
+		}
+
+		constexpr inline size_t Size() const noexcept {
+			return _table.Size();
+		}
+
+		constexpr inline uint32_t Capacity() const noexcept {
+			return _table.Capacity();
+		}
+
+		// allocators that don't propagate on swap must be equal
+		inline void Swap(Set& other) noexcept {
+			_table.Swap(other._table);
+		}
+
+		inline Iterator begin() const noexcept {
+			return _table.begin();
+		}
+
+		inline ConstIterator end() const noexcept {
+			return _table.end();
 		}
 
 	private:
 
-		uint32_t _capacity;
-		Bucket* _buckets;
-		simple::DynamicArray<Element*> _elements;
-		uint32_t _trash;
+		Table _table;
 	};
 }
@@ -0,0 +1,489 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#include <immintrin.h>
+#ifndef SIMPLE_SSE2
+#define SIMPLE_SSE2
+#endif
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define SIMPLE_TARGET_AVX2
+#define SIMPLE_NO_SANITIZE_ADDRESS __declspec(no_sanitize_address)
+#else
+#define SIMPLE_TARGET_AVX2 __attribute__((target("avx2")))
+#define SIMPLE_NO_SANITIZE_ADDRESS __attribute__((no_sanitize_address))
+#endif
+
+namespace simple {
+
+	// String and array search kernels. Each function has an SSE2 and an AVX2 version, the AVX2 one is picked at run time
+	// when the cpu supports it (or always, when compiling with AVX2 enabled). Without SSE2 they fall back to the C library.
+	namespace simd {
+
+		static constexpr inline size_t npos = SIZE_MAX;
+
+		inline bool DetectAvx2() noexcept {
+#if defined(__AVX2__)
+			return true;
+#elif defined(SIMPLE_SSE2) && defined(_MSC_VER)
+			int info[4];
+			__cpuid(info, 0);
+			if (info[0] < 7) {
+				return false;
+			}
+			__cpuid(info, 1);
+			// the os has to save the ymm registers on context switches
+			if (!(info[2] & (1 << 27)) || !(info[2] & (1 << 28)) || (_xgetbv(0) & 6) != 6) {
+				return false;
+			}
+			__cpuidex(info, 7, 0);
+			return info[1] & (1 << 5);
+#elif defined(SIMPLE_SSE2)
+			return __builtin_cpu_supports("avx2");
+#else
+			return false;
+#endif
+		}
+
+		// reads as false until initialized, which only means the SSE2 kernels get used during static initialization,
+		// not const so that tests can clear it to run the SSE2 kernels on an AVX2 machine
+		inline bool cpu_has_avx2 = DetectAvx2();
+
+		// below 16 bytes, without reading past either range
+		inline bool SmallEqual(const char* a, const char* b, size_t length) noexcept {
+			if (length >= 8) {
+				uint64_t a0, a1, b0, b1;
+				std::memcpy(&a0, a, 8);
+				std::memcpy(&b0, b, 8);
+				std::memcpy(&a1, a + length - 8, 8);
+				std::memcpy(&b1, b + length - 8, 8);
+				return ((a0 ^ b0) | (a1 ^ b1)) == 0;
+			}
+			if (length >= 4) {
+				uint32_t a0, a1, b0, b1;
+				std::memcpy(&a0, a, 4);
+				std::memcpy(&b0, b, 4);
+				std::memcpy(&a1, a + length - 4, 4);
+				std::memcpy(&b1, b + length - 4, 4);
+				return ((a0 ^ b0) | (a1 ^ b1)) == 0;
+			}
+			for (size_t i = 0; i < length; i++) {
+				if (a[i] != b[i]) {
+					return false;
+				}
+			}
+			return true;
+		}
+
+#ifdef SIMPLE_SSE2
+
+		namespace sse2 {
+
+			// aligned loads never cross a page boundary, so reading a few bytes around the string is safe
+			SIMPLE_NO_SANITIZE_ADDRESS inline size_t Length(const char* string) noexcept {
+				const __m128i zero = _mm_setzero_si128();
+				uintptr_t address = reinterpret_cast<uintptr_t>(string);
+				uint32_t misalignment = address & 15;
+				const char* block = reinterpret_cast<const char*>(address - misalignment);
+				uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_load_si128(reinterpret_cast<const __m128i*>(block)), zero))) >> misalignment;
+				if (mask) {
+					return std::countr_zero(mask);
+				}
+				// single blocks up to a cache line boundary, then whole cache lines folded with an unsigned min
+				for (block += 16; reinterpret_cast<uintptr_t>(block) & 63; block += 16) {
+					mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_load_si128(reinterpret_cast<const __m128i*>(block)), zero));
+					if (mask) {
+						return block - string + std::countr_zero(mask);
+					}
+				}
+				for (;; block += 64) {
+					const __m128i* line = reinterpret_cast<const __m128i*>(block);
+					__m128i min = _mm_min_epu8(_mm_min_epu8(_mm_load_si128(line), _mm_load_si128(line + 1)),
+						_mm_min_epu8(_mm_load_si128(line + 2), _mm_load_si128(line + 3)));
+					if (_mm_movemask_epi8(_mm_cmpeq_epi8(min, zero))) {
+						break;
+					}
+				}
+				for (;; block += 16) {
+					mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_load_si128(reinterpret_cast<const __m128i*>(block)), zero));
+					if (mask) {
+						return block - string + std::countr_zero(mask);
+					}
+				}
+			}
+
+			inline uint32_t EqualMask(const char* a, const char* b) noexcept {
+				__m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a));
+				__m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b));
+				return _mm_movemask_epi8(_mm_cmpeq_epi8(va, vb));
+			}
+
+			inline bool Equal(const char* a, const char* b, size_t length) noexcept {
+				if (length < 16) {
+					return SmallEqual(a, b, length);
+				}
+				size_t i = 0;
+				for (; i + 16 <= length; i += 16) {
+					if (EqualMask(a + i, b + i) != 0xffff) {
+						return false;
+					}
+				}
+				// the last block overlaps bytes that already matched
+				return i == length || EqualMask(a + length - 16, b + length - 16) == 0xffff;
+			}
+
+			inline size_t Mismatch(const char* a, const char* b, size_t length) noexcept {
+				size_t i = 0;
+				for (; i + 16 <= length; i += 16) {
+					uint32_t mask = ~EqualMask(a + i, b + i) & 0xffff;
+					if (mask) {
+						return i + std::countr_zero(mask);
+					}
+				}
+				if (i != length && length >= 16) {
+					uint32_t mask = ~EqualMask(a + length - 16, b + length - 16) & 0xffff;
+					return mask ? length - 16 + std::countr_zero(mask) : length;
+				}
+				for (; i < length; i++) {
+					if (a[i] != b[i]) {
+						return i;
+					}
+				}
+				return length;
+			}
+
+			inline size_t FindChar(const char* string, size_t length, char c) noexcept {
+				const __m128i needle = _mm_set1_epi8(c);
+				size_t i = 0;
+				for (; i + 16 <= length; i += 16) {
+					uint32_t mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(string + i)), needle));
+					if (mask) {
+						return i + std::countr_zero(mask);
+					}
+				}
+				for (; i < length; i++) {
+					if (string[i] == c) {
+						return i;
+					}
+				}
+				return npos;
+			}
+
+			// compares the first and last character of the needle at 16 positions at once, then verifies the candidates
+			inline size_t FindString(const char* haystack, size_t haystackLength, const char* needle, size_t needleLength) noexcept {
+				const __m128i first = _mm_set1_epi8(needle[0]);
+				const __m128i last = _mm_set1_epi8(needle[needleLength - 1]);
+				size_t i = 0;
+				for (; i + 16 + needleLength - 1 <= haystackLength; i += 16) {
+					__m128i blockFirst = _mm_loadu_si128(reinterpret_cast<const __m128i*>(haystack + i));
+					__m128i blockLast = _mm_loadu_si128(reinterpret_cast<const __m128i*>(haystack + i + needleLength - 1));
+					uint32_t mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(first, blockFirst), _mm_cmpeq_epi8(last, blockLast)));
+					while (mask) {
+						size_t index = i + std::countr_zero(mask);
+						if (!std::memcmp(haystack + index + 1, needle + 1, needleLength - 2)) {
+							return index;
+						}
+						mask &= mask - 1;
+					}
+				}
+				for (; i + needleLength <= haystackLength; i++) {
+					if (haystack[i] == needle[0] && !std::memcmp(haystack + i + 1, needle + 1, needleLength - 1)) {
+						return i;
+					}
+				}
+				return npos;
+			}
+
+			template<typename T>
+			inline __m128i CompareEqual(__m128i a, __m128i b) noexcept {
+				if constexpr (sizeof(T) == 1) {
+					return _mm_cmpeq_epi8(a, b);
+				}
+				else if constexpr (sizeof(T) == 2) {
+					return _mm_cmpeq_epi16(a, b);
+				}
+				else if constexpr (sizeof(T) == 4) {
+					return _mm_cmpeq_epi32(a, b);
+				}
+				else {
+					// SSE2 has no 64 bit compare, both 32 bit halves have to match
+					__m128i equal = _mm_cmpeq_epi32(a, b);
+					return _mm_and_si128(equal, _mm_shuffle_epi32(equal, _MM_SHUFFLE(2, 3, 0, 1)));
+				}
+			}
+
+			template<typename T>
+			inline __m128i Broadcast(T value) noexcept {
+				if constexpr (sizeof(T) == 1) {
+					return _mm_set1_epi8(static_cast<char>(value));
+				}
+				else if constexpr (sizeof(T) == 2) {
+					return _mm_set1_epi16(static_cast<short>(value));
+				}
+				else if constexpr (sizeof(T) == 4) {
+					return _mm_set1_epi32(static_cast<int>(value));
+				}
+				else {
+					return _mm_set1_epi64x(static_cast<long long>(value));
+				}
+			}
+
+			template<typename T>
+			inline size_t FindValue(const T* data, size_t count, T value) noexcept {
+				constexpr size_t lanes = 16 / sizeof(T);
+				const __m128i needle = Broadcast(value);
+				size_t i = 0;
+				for (; i + lanes <= count; i += lanes) {
+					__m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+					uint32_t mask = _mm_movemask_epi8(CompareEqual<T>(block, needle));
+					if (mask) {
+						return i + std::countr_zero(mask) / sizeof(T);
+					}
+				}
+				for (; i < count; i++) {
+					if (data[i] == value) {
+						return i;
+					}
+				}
+				return npos;
+			}
+		}
+
+		namespace avx2 {
+
+			SIMPLE_TARGET_AVX2 SIMPLE_NO_SANITIZE_ADDRESS inline size_t Length(const char* string) noexcept {
+				const __m256i zero = _mm256_setzero_si256();
+				uintptr_t address = reinterpret_cast<uintptr_t>(string);
+				uint32_t misalignment = address & 31;
+				const char* block = reinterpret_cast<const char*>(address - misalignment);
+				uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_load_si256(reinterpret_cast<const __m256i*>(block)), zero))) >> misalignment;
+				if (mask) {
+					return std::countr_zero(mask);
+				}
+				block += 32;
+				if (reinterpret_cast<uintptr_t>(block) & 63) {
+					mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_load_si256(reinterpret_cast<const __m256i*>(block)), zero));
+					if (mask) {
+						return block - string + std::countr_zero(mask);
+					}
+					block += 32;
+				}
+				for (;; block += 64) {
+					const __m256i* line = reinterpret_cast<const __m256i*>(block);
+					__m256i min = _mm256_min_epu8(_mm256_load_si256(line), _mm256_load_si256(line + 1));
+					if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(min, zero))) {
+						break;
+					}
+				}
+				for (;; block += 32) {
+					mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_load_si256(reinterpret_cast<const __m256i*>(block)), zero));
+					if (mask) {
+						return block - string + std::countr_zero(mask);
+					}
+				}
+			}
+
+			SIMPLE_TARGET_AVX2 inline uint32_t EqualMask(const char* a, const char* b) noexcept {
+				__m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a));
+				__m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b));
+				return _mm256_movemask_epi8(_mm256_cmpeq_epi8(va, vb));
+			}
+
+			SIMPLE_TARGET_AVX2 inline bool Equal(const char* a, const char* b, size_t length) noexcept {
+				if (length < 32) {
+					return sse2::Equal(a, b, length);
+				}
+				size_t i = 0;
+				for (; i + 32 <= length; i += 32) {
+					if (EqualMask(a + i, b + i) != UINT32_MAX) {
+						return false;
+					}
+				}
+				return i == length || EqualMask(a + length - 32, b + length - 32) == UINT32_MAX;
+			}
+
+			SIMPLE_TARGET_AVX2 inline size_t Mismatch(const char* a, const char* b, size_t length) noexcept {
+				if (length < 32) {
+					return sse2::Mismatch(a, b, length);
+				}
+				size_t i = 0;
+				for (; i + 32 <= length; i += 32) {
+					uint32_t mask = ~EqualMask(a + i, b + i);
+					if (mask) {
+						return i + std::countr_zero(mask);
+					}
+				}
+				if (i != length) {
+					uint32_t mask = ~EqualMask(a + length - 32, b + length - 32);
+					return mask ? length - 32 + std::countr_zero(mask) : length;
+				}
+				return length;
+			}
+
+			SIMPLE_TARGET_AVX2 inline size_t FindChar(const char* string, size_t length, char c) noexcept {
+				const __m256i needle = _mm256_set1_epi8(c);
+				size_t i = 0;
+				for (; i + 32 <= length; i += 32) {
+					uint32_t mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(string + i)), needle));
+					if (mask) {
+						return i + std::countr_zero(mask);
+					}
+				}
+				size_t index = sse2::FindChar(string + i, length - i, c);
+				return index == npos ? npos : i + index;
+			}
+
+			SIMPLE_TARGET_AVX2 inline size_t FindString(const char* haystack, size_t haystackLength, const char* needle, size_t needleLength) noexcept {
+				const __m256i first = _mm256_set1_epi8(needle[0]);
+				const __m256i last = _mm256_set1_epi8(needle[needleLength - 1]);
+				size_t i = 0;
+				for (; i + 32 + needleLength - 1 <= haystackLength; i += 32) {
+					__m256i blockFirst = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(haystack + i));
+					__m256i blockLast = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(haystack + i + needleLength - 1));
+					uint32_t mask = _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(first, blockFirst), _mm256_cmpeq_epi8(last, blockLast)));
+					while (mask) {
+						size_t index = i + std::countr_zero(mask);
+						if (!std::memcmp(haystack + index + 1, needle + 1, needleLength - 2)) {
+							return index;
+						}
+						mask &= mask - 1;
+					}
+				}
+				size_t index = sse2::FindString(haystack + i, haystackLength - i, needle, needleLength);
+				return index == npos ? npos : i + index;
+			}
+
+			template<typename T>
+			SIMPLE_TARGET_AVX2 inline size_t FindValue(const T* data, size_t count, T value) noexcept {
+				constexpr size_t lanes = 32 / sizeof(T);
+				__m256i needle;
+				if constexpr (sizeof(T) == 1) {
+					needle = _mm256_set1_epi8(static_cast<char>(value));
+				}
+				else if constexpr (sizeof(T) == 2) {
+					needle = _mm256_set1_epi16(static_cast<short>(value));
+				}
+				else if constexpr (sizeof(T) == 4) {
+					needle = _mm256_set1_epi32(static_cast<int>(value));
+				}
+				else {
+					needle = _mm256_set1_epi64x(static_cast<long long>(value));
+				}
+				size_t i = 0;
+				for (; i + lanes <= count; i += lanes) {
+					__m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+					__m256i equal;
+					if constexpr (sizeof(T) == 1) {
+						equal = _mm256_cmpeq_epi8(block, needle);
+					}
+					else if constexpr (sizeof(T) == 2) {
+						equal = _mm256_cmpeq_epi16(block, needle);
+					}
+					else if constexpr (sizeof(T) == 4) {
+						equal = _mm256_cmpeq_epi32(block, needle);
+					}
+					else {
+						equal = _mm256_cmpeq_epi64(block, needle);
+					}
+					uint32_t mask = _mm256_movemask_epi8(equal);
+					if (mask) {
+						return i + std::countr_zero(mask) / sizeof(T);
+					}
+				}
+				size_t index = sse2::FindValue(data + i, count - i, value);
+				return index == npos ? npos : i + index;
+			}
+		}
+
+#endif
+
+		// length of a null terminated string
+		inline size_t Length(const char* string) noexcept {
+#ifdef SIMPLE_SSE2
+			return cpu_has_avx2 ? avx2::Length(string) : sse2::Length(string);
+#else
+			return std::strlen(string);
+#endif
+		}
+
+		inline bool Equal(const char* a, const char* b, size_t length) noexcept {
+#ifdef SIMPLE_SSE2
+			return cpu_has_avx2 ? avx2::Equal(a, b, length) : sse2::Equal(a, b, length);
+#else
+			return !length || !std::memcmp(a, b, length);
+#endif
+		}
+
+		// index of the first character that differs between a and b, or length if they're equal
+		inline size_t Mismatch(const char* a, const char* b, size_t length) noexcept {
+#ifdef SIMPLE_SSE2
+			return cpu_has_avx2 ? avx2::Mismatch(a, b, length) : sse2::Mismatch(a, b, length);
+#else
+			size_t i = 0;
+			while (i < length && a[i] == b[i]) {
+				i++;
+			}
+			return i;
+#endif
+		}
+
+		// index of the first c in string, or npos
+		inline size_t FindChar(const char* string, size_t length, char c) noexcept {
+#ifdef SIMPLE_SSE2
+			return cpu_has_avx2 ? avx2::FindChar(string, length, c) : sse2::FindChar(string, length, c);
+#else
+			const void* result = length ? std::memchr(string, c, length) : nullptr;
+			return result ? static_cast<const char*>(result) - string : npos;
+#endif
+		}
+
+		// index of the first occurrence of needle in haystack, or npos
+		inline size_t FindString(const char* haystack, size_t haystackLength, const char* needle, size_t needleLength) noexcept {
+			if (!needleLength) {
+				return 0;
+			}
+			if (needleLength > haystackLength) {
+				return npos;
+			}
+			if (needleLength == 1) {
+				return FindChar(haystack, haystackLength, needle[0]);
+			}
+#ifdef SIMPLE_SSE2
+			return cpu_has_avx2 ? avx2::FindString(haystack, haystackLength, needle, needleLength)
+				: sse2::FindString(haystack, haystackLength, needle, needleLength);
+#else
+			for (size_t i = 0; i + needleLength <= haystackLength; i++) {
+				if (!std::memcmp(haystack + i, needle, needleLength)) {
+					return i;
+				}
+			}
+			return npos;
+#endif
+		}
+
+		// index of the first value in data, or npos
+		template<typename T>
+		inline size_t FindValue(const T* data, size_t count, T value) noexcept {
+			static_assert(std::is_integral_v<T> && sizeof(T) <= 8, "simple::simd::FindValue only supports integral types!");
+#ifdef SIMPLE_SSE2
+			return cpu_has_avx2 ? avx2::FindValue(data, count, value) : sse2::FindValue(data, count, value);
+#else
+			for (size_t i = 0; i < count; i++) {
+				if (data[i] == value) {
+					return i;
+				}
+			}
+			return npos;
+#endif
+		}
+	}
+}
@@ -0,0 +1,169 @@
+#pragma once
+
+#include "simple_allocator.hpp"
+#include "simple_dynamic_array.hpp"
+#include <assert.h>
+#include <cstdint>
+#include <utility>
+
+namespace simple {
+
+	// Stable 64 bit handle to an element of a simple::SlotMap, the low 32 bits are the slot index
+	// and the high 32 bits the generation of the slot when the handle was issued
+	struct SlotHandle {
+
+		uint64_t value{};
+
+		constexpr inline SlotHandle() noexcept = default;
+
+		constexpr inline SlotHandle(uint32_t index, uint32_t generation) noexcept
+			: value(((uint64_t)generation << 32) | index) {}
+
+		constexpr inline uint32_t Index() const noexcept {
+			return (uint32_t)value;
+		}
+
+		constexpr inline uint32_t Generation() const noexcept {
+			return (uint32_t)(value >> 32);
+		}
+
+		constexpr inline bool IsNull() const noexcept {
+			return !value;
+		}
+
+		constexpr inline bool operator==(const SlotHandle& other) const noexcept {
+			return value == other.value;
+		}
+
+		struct Hash {
+			inline uint64_t operator()(const SlotHandle& handle) const {
+				return handle.value;
+			}
+		};
+	};
+
+	// Values are kept densely packed for iteration, while handles stay valid until the element they refer to is erased.
+	// Erasing moves the last value into the hole, so pointers to values are only valid until the next Emplace/Erase.
+	template<typename T, class Allocator = DynamicAllocator<T>>
+	class SlotMap {
+	public:
+
+		typedef SlotHandle Handle;
+		typedef T* Iterator;
+		typedef const T* ConstIterator;
+
+		inline SlotMap() noexcept : _values(), _valueSlots(), _slots(), _freeSlot(no_free_slot) {}
+
+		// allocator is used for the values, the slot bookkeeping uses the default allocator
+		explicit inline SlotMap(const Allocator& allocator) noexcept : _values(allocator), _valueSlots(), _slots(), _freeSlot(no_free_slot) {}
+
+		inline SlotMap(SlotMap&& other) noexcept
+			: _values(std::move(other._values)), _valueSlots(std::move(other._valueSlots)), _slots(std::move(other._slots)),
+				_freeSlot(other._freeSlot) {
+			other._freeSlot = no_free_slot;
+		}
+
+		SlotMap(const SlotMap&) = delete;
+
+		constexpr inline uint32_t Size() const noexcept {
+			return _values.Size();
+		}
+
+		inline void Reserve(uint32_t capacity) {
+			_values.Reserve(capacity);
+			_valueSlots.Reserve(capacity);
+			_slots.Reserve(capacity);
+		}
+
+		template<typename... Args>
+		inline Handle Emplace(Args&&... args) {
+			uint32_t slotIndex = _freeSlot;
+			if (slotIndex == no_free_slot) {
+				slotIndex = _slots.Size();
+				_slots.PushBack({ .valueIndex = 0, .generation = 1 });
+			}
+			else {
+				_freeSlot = _slots[slotIndex].valueIndex;
+			}
+			Slot& slot = _slots[slotIndex];
+			slot.valueIndex = _values.Size();
+			_values.EmplaceBack(std::forward<Args>(args)...);
+			_valueSlots.PushBack(slotIndex);
+			return Handle(slotIndex, slot.generation);
+		}
+
+		inline Handle Insert(const T& value) {
+			return Emplace(value);
+		}
+
+		inline bool Contains(Handle handle) const noexcept {
+			return handle.Index() < _slots.Size() && _slots[handle.Index()].generation == handle.Generation();
+		}
+
+		inline T* Find(Handle handle) const noexcept {
+			if (!Contains(handle)) {
+				return nullptr;
+			}
+			return &_values[_slots[handle.Index()].valueIndex];
+		}
+
+		inline bool Erase(Handle handle) {
+			if (!Contains(handle)) {
+				return false;
+			}
+			Slot& slot = _slots[handle.Index()];
+			uint32_t valueIndex = slot.valueIndex;
+			uint32_t lastIndex = _values.Size() - 1;
+			_values.EraseUnordered(&_values[valueIndex]);
+			_valueSlots.EraseUnordered(&_valueSlots[valueIndex]);
+			if (valueIndex != lastIndex) {
+				_slots[_valueSlots[valueIndex]].valueIndex = valueIndex;
+			}
+			// generation 0 is never handed out, so null handles can't match a slot
+			slot.generation = slot.generation + 1 ? slot.generation + 1 : 1;
+			slot.valueIndex = _freeSlot;
+			_freeSlot = handle.Index();
+			return true;
+		}
+
+		inline void Clear() {
+			for (uint32_t valueSlot : _valueSlots) {
+				Slot& slot = _slots[valueSlot];
+				slot.generation = slot.generation + 1 ? slot.generation + 1 : 1;
+				slot.valueIndex = _freeSlot;
+				_freeSlot = valueSlot;
+			}
+			_values.Clear();
+			_valueSlots.Clear();
+		}
+
+		// handle of the value at index in dense storage, e.g. while iterating
+		inline Handle GetHandle(uint32_t valueIndex) const noexcept {
+			uint32_t slotIndex = _valueSlots[valueIndex];
+			return Handle(slotIndex, _slots[slotIndex].generation);
+		}
+
+		inline Iterator begin() const noexcept {
+			return _values.begin();
+		}
+
+		inline ConstIterator end() const noexcept {
+			return _values.end();
+		}
+
+	private:
+
+		static constexpr inline uint32_t no_free_slot = UINT32_MAX;
+
+		struct Slot {
+			// index into _values while occupied, next free slot while free
+			uint32_t valueIndex;
+			uint32_t generation;
+		};
+
+		DynamicArray<T, Allocator> _values;
+		DynamicArray<uint32_t> _valueSlots;
+		DynamicArray<Slot> _slots;
+		uint32_t _freeSlot;
+	};
+}
@@ -0,0 +1,418 @@
+#pragma once
+
+#include "simple_allocator.hpp"
+#include "simple_simd.hpp"
+#include <assert.h>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+namespace simple {
+
+	// simple::DynamicArray that keeps up to T_inline_capacity elements inside the object itself and only
+	// uses the allocator once it grows past that
+	template<typename T, uint32_t T_inline_capacity, class Allocator = DynamicAllocator<T>>
+	class SmallDynamicArray {
+	public:
+
+		static_assert(T_inline_capacity > 0, "simple::SmallDynamicArray inline capacity must be greater than zero!");
+
+		typedef T* Iterator;
+		typedef const T* ConstIterator;
+
+		constexpr inline SmallDynamicArray() : _allocator(), _capacity(T_inline_capacity), _size(0), _pData(_InlineData()) {}
+
+		constexpr explicit inline SmallDynamicArray(const Allocator& allocator) noexcept
+			: _allocator(allocator), _capacity(T_inline_capacity), _size(0), _pData(_InlineData()) {}
+
+		constexpr inline SmallDynamicArray(ConstIterator begin, ConstIterator end, const Allocator& allocator = Allocator())
+			: _allocator(allocator), _capacity(T_inline_capacity), _size(0), _pData(_InlineData()) {
+			AppendRange(begin, end);
+		}
+
+		constexpr inline SmallDynamicArray(const SmallDynamicArray& other)
+			: SmallDynamicArray(other, AllocatorTraits<Allocator>::SelectOnCopy(other._allocator)) {}
+
+		constexpr inline SmallDynamicArray(const SmallDynamicArray& other, const Allocator& allocator)
+			: _allocator(allocator), _capacity(T_inline_capacity), _size(0), _pData(_InlineData()) {
+			Reserve(other._size);
+			for (uint32_t i = 0; i < other._size; i++) {
+				_allocator.construct(&_pData[i], other._pData[i]);
+			}
+			_size = other._size;
+		}
+
+		constexpr inline SmallDynamicArray(SmallDynamicArray&& other) noexcept
+			: _allocator(other._allocator), _capacity(T_inline_capacity), _size(0), _pData(_InlineData()) {
+			_Steal(other);
+		}
+
+		// steals the memory of other if the allocators are equal, moves the elements one by one otherwise
+		constexpr inline SmallDynamicArray(SmallDynamicArray&& other, const Allocator& allocator)
+			: _allocator(allocator), _capacity(T_inline_capacity), _size(0), _pData(_InlineData()) {
+			_Steal(other);
+		}
+
+		constexpr inline SmallDynamicArray(uint32_t size, const Allocator& allocator = Allocator())
+			: _allocator(allocator), _capacity(T_inline_capacity), _size(0), _pData(_InlineData()) {
+			Resize(size);
+		}
+
+		constexpr inline const Allocator& GetAllocator() const noexcept {
+			return _allocator;
+		}
+
+		constexpr inline uint32_t Capacity() const noexcept {
+			return _capacity;
+		}
+
+		constexpr inline uint32_t Size() const noexcept {
+			return _size;
+		}
+
+		constexpr inline T* Data() const noexcept {
+			return _pData;
+		}
+
+		constexpr inline bool IsInline() const noexcept {
+			return _pData == _InlineData();
+		}
+
+		constexpr inline SmallDynamicArray& Reserve(uint32_t capacity) {
+			if (capacity <= _capacity) {
+				return *this;
+			}
+			uint32_t oldCapacity = _capacity;
+			while (_capacity < capacity) {
+				_capacity *= 2;
+			}
+			if (!IsInline()) {
+				if constexpr (trivially_relocatable<T> && ReallocatingAllocator<Allocator, T>) {
+					T* temp = _allocator.reallocate(_pData, oldCapacity, _capacity);
+					assert(temp && "failed to allocate memory!");
+					_pData = temp;
+					return *this;
+				}
+			}
+			T* temp = _allocator.allocate(_capacity);
+			assert(temp && "failed to allocate memory!");
+			Relocate(_allocator, temp, _pData, _size);
+			if (!IsInline()) {
+				_allocator.deallocate(_pData, oldCapacity);
+			}
+			_pData = temp;
+			return *this;
+		}
+
+		// value initializes the new elements
+		constexpr inline SmallDynamicArray& Resize(uint32_t size) {
+			Reserve(size);
+			for (uint32_t i = size; i < _size; i++) {
+				_allocator.destroy(&_pData[i]);
+			}
+			for (uint32_t i = _size; i < size; i++) {
+				_allocator.construct(&_pData[i]);
+			}
+			_size = size;
+			return *this;
+		}
+
+		// default initializes the new elements, which leaves trivial types uninitialized
+		constexpr inline SmallDynamicArray& ResizeDefault(uint32_t size) {
+			Reserve(size);
+			for (uint32_t i = size; i < _size; i++) {
+				_allocator.destroy(&_pData[i]);
+			}
+			for (uint32_t i = _size; i < size; i++) {
+				new(&_pData[i]) T;
+			}
+			_size = size;
+			return *this;
+		}
+
+		// changes the size without touching the elements, meant for buffers that are written to right after (e.g. by vulkan)
+		constexpr inline SmallDynamicArray& ResizeUninitialized(uint32_t size) {
+			static_assert(std::is_trivially_default_constructible_v<T> && std::is_trivially_destructible_v<T>,
+				"attempting to call simple::SmallDynamicArray::ResizeUninitialized with a type that isn't trivial!");
+			Reserve(size);
+			_size = size;
+			return *this;
+		}
+
+		constexpr inline T& PushBack(const T& value) {
+			return EmplaceBack(value);
+		}
+
+		constexpr inline Iterator Insert(Iterator where, const T& value) {
+			return Emplace(where, value);
+		}
+
+		template<typename... Args>
+		constexpr inline T& EmplaceBack(Args&&... args) {
+			if (_size >= _capacity) {
+				T value(std::forward<Args>(args)...);
+				Reserve(_capacity * 2);
+				_allocator.construct(&_pData[_size], std::move(value));
+			}
+			else {
+				_allocator.construct(&_pData[_size], std::forward<Args>(args)...);
+			}
+			return _pData[_size++];
+		}
+
+		template<typename... Args>
+		constexpr inline Iterator Emplace(Iterator where, Args&&... args) {
+			ptrdiff_t index = where - _pData;
+			assert(index >= 0 && index <= _size
+				&& "attempting to emplace to simple::SmallDynamicArray (function simple::SmallDynamicArray::Emplace) with an iterator that doesn't belong to the simple::SmallDynamicArray");
+			if (index == _size) {
+				return &EmplaceBack(std::forward<Args>(args)...);
+			}
+			T value(std::forward<Args>(args)...);
+			if (_size >= _capacity) {
+				Reserve(_capacity * 2);
+			}
+			where = &_pData[index];
+			Relocate(_allocator, where + 1, where, _size - index);
+			_allocator.construct(where, std::move(value));
+			++_size;
+			return where;
+		}
+
+		constexpr inline Iterator Erase(Iterator where) {
+			ptrdiff_t index = where - _pData;
+			assert(index < _size && index >= 0
+				&& "attempting to erase from simple::SmallDynamicArray (function simple::SmallDynamicArray::Erase) with an iterator that doesn't belong to the simple::SmallDynamicArray");
+			_allocator.destroy(where);
+			Relocate(_allocator, where, where + 1, _size - index - 1);
+			--_size;
+			return &_pData[index];
+		}
+
+		// O(1) erase that moves the last element into the erased slot, so element order is not preserved
+		constexpr inline Iterator EraseUnordered(Iterator where) {
+			ptrdiff_t index = where - _pData;
+			assert(index < _size && index >= 0
+				&& "attempting to erase from simple::SmallDynamicArray (function simple::SmallDynamicArray::EraseUnordered) with an iterator that doesn't belong to the simple::SmallDynamicArray");
+			_allocator.destroy(where);
+			--_size;
+			if (index != _size) {
+				Relocate(_allocator, where, &_pData[_size], 1);
+			}
+			return where;
+		}
+
+		constexpr inline SmallDynamicArray& AppendRange(ConstIterator begin, ConstIterator end) {
+			ptrdiff_t count = end - begin;
+			assert(count >= 0 && _size + count <= UINT32_MAX && "invalid range (function simple::SmallDynamicArray::AppendRange)!");
+			if (!count) {
+				return *this;
+			}
+			// the range may lie in this array, which reserving can free, pointers into other arrays can't be subtracted from _pData
+			bool fromSelf = begin >= _pData && begin < _pData + _size;
+			ptrdiff_t selfOffset = fromSelf ? begin - _pData : 0;
+			Reserve(_size + (uint32_t)count);
+			if (fromSelf) {
+				begin = &_pData[selfOffset];
+			}
+			UninitializedCopy(_allocator, &_pData[_size], begin, count);
+			_size += (uint32_t)count;
+			return *this;
+		}
+
+		constexpr inline Iterator InsertRange(Iterator where, ConstIterator begin, ConstIterator end) {
+			ptrdiff_t index = where - _pData;
+			ptrdiff_t count = end - begin;
+			assert(index >= 0 && index <= _size
+				&& "attempting to insert to simple::SmallDynamicArray (function simple::SmallDynamicArray::InsertRange) with an iterator that doesn't belong to the simple::SmallDynamicArray");
+			assert(count >= 0 && _size + count <= UINT32_MAX && "invalid range (function simple::SmallDynamicArray::InsertRange)!");
+			if (index == _size) {
+				AppendRange(begin, end);
+				return &_pData[index];
+			}
+			if (!count) {
+				return where;
+			}
+			assert((begin >= &_pData[_size] || end <= _pData) && "attempting to insert a range of the simple::SmallDynamicArray into itself (function simple::SmallDynamicArray::InsertRange)!");
+			Reserve(_size + (uint32_t)count);
+			where = &_pData[index];
+			Relocate(_allocator, where + count, where, _size - index);
+			UninitializedCopy(_allocator, where, begin, count);
+			_size += (uint32_t)count;
+			return where;
+		}
+
+		constexpr inline Iterator EraseRange(Iterator first, Iterator last) {
+			ptrdiff_t index = first - _pData;
+			ptrdiff_t count = last - first;
+			assert(index >= 0 && count >= 0 && index + count <= _size
+				&& "attempting to erase from simple::SmallDynamicArray (function simple::SmallDynamicArray::EraseRange) with a range that doesn't belong to the simple::SmallDynamicArray");
+			for (Iterator iter = first; iter != last; ++iter) {
+				_allocator.destroy(iter);
+			}
+			Relocate(_allocator, first, last, _size - index - count);
+			_size -= (uint32_t)count;
+			return &_pData[index];
+		}
+
+		constexpr inline Iterator Back() {
+			return &_pData[_size - 1];
+		}
+
+		constexpr inline void Clear() {
+			for (uint32_t i = 0; i < _size; i++) {
+				_allocator.destroy(&_pData[i]);
+			}
+			_size = 0;
+			if (!IsInline()) {
+				_allocator.deallocate(_pData, _capacity);
+				_pData = _InlineData();
+				_capacity = T_inline_capacity;
+			}
+		}
+
+		constexpr inline Iterator Find(const T& value) {
+			if constexpr (std::is_integral_v<T>) {
+				if (!std::is_constant_evaluated()) {
+					size_t index = simd::FindValue<T>(_pData, _size, value);
+					return index == simd::npos ? &_pData[_size] : &_pData[index];
+				}
+			}
+			Iterator begin = &_pData[0];
+			for (; begin != &_pData[_size];) {
+				if (*begin == value) {
+					break;
+				}
+				++begin;
+			}
+			return begin;
+		}
+
+		constexpr inline SmallDynamicArray& Reverse() {
+			if (!_size) {
+				return *this;
+			}
+			for (uint32_t i = 0, j = _size - 1; i < j; ++i, --j) {
+				T temp(std::move(_pData[i]));
+				_pData[i] = std::move(_pData[j]);
+				_pData[j] = std::move(temp);
+			}
+			return *this;
+		}
+
+		constexpr inline Iterator begin() const {
+			return &_pData[0];
+		}
+
+		constexpr inline ConstIterator end() const {
+			return &_pData[_size];
+		}
+
+		constexpr ~SmallDynamicArray() noexcept {
+			Clear();
+		}
+
+		constexpr T& operator[](size_t index) const {
+			assert(index < _size && "attempting to access index that's out side the bounds of simple::SmallDynamicArray!");
+			return _pData[index];
+		}
+
+		constexpr SmallDynamicArray& operator=(const SmallDynamicArray& other) {
+			if (this == &other) {
+				return *this;
+			}
+			if constexpr (AllocatorTraits<Allocator>::propagate_on_copy) {
+				if (!AllocatorTraits<Allocator>::Equal(_allocator, other._allocator)) {
+					Clear();
+				}
+				_allocator = other._allocator;
+			}
+			// keeps the current storage, it's only replaced if other doesn't fit
+			for (uint32_t i = 0; i < _size; i++) {
+				_allocator.destroy(&_pData[i]);
+			}
+			_size = 0;
+			AppendRange(other.begin(), other.end());
+			return *this;
+		}
+
+		constexpr SmallDynamicArray& operator=(SmallDynamicArray&& other) noexcept(AllocatorTraits<Allocator>::propagate_on_move || AllocatorTraits<Allocator>::always_equal) {
+			if (this == &other) {
+				return *this;
+			}
+			Clear();
+			if constexpr (AllocatorTraits<Allocator>::propagate_on_move) {
+				_allocator = other._allocator;
+			}
+			_Steal(other);
+			return *this;
+		}
+
+		// allocators that don't propagate on swap must be equal, inline elements are moved between the arrays
+		constexpr inline void Swap(SmallDynamicArray& other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+			if constexpr (!AllocatorTraits<Allocator>::propagate_on_swap) {
+				assert(AllocatorTraits<Allocator>::Equal(_allocator, other._allocator)
+					&& "attempting to swap simple::SmallDynamicArrays with unequal allocators (function simple::SmallDynamicArray::Swap)!");
+			}
+			if (this == &other) {
+				return;
+			}
+			if (!IsInline() && !other.IsInline()) {
+				if constexpr (AllocatorTraits<Allocator>::propagate_on_swap) {
+					std::swap(_allocator, other._allocator);
+				}
+				std::swap(_capacity, other._capacity);
+				std::swap(_size, other._size);
+				std::swap(_pData, other._pData);
+				return;
+			}
+			SmallDynamicArray temp(std::move(*this));
+			if constexpr (AllocatorTraits<Allocator>::propagate_on_swap) {
+				_allocator = other._allocator;
+			}
+			_Steal(other);
+			if constexpr (AllocatorTraits<Allocator>::propagate_on_swap) {
+				other._allocator = temp._allocator;
+			}
+			other._Steal(temp);
+		}
+
+	private:
+
+		constexpr inline T* _InlineData() const noexcept {
+			return (T*)_inlineData;
+		}
+
+		// expects this array to be empty and inline, heap memory is only taken over if the allocators are equal
+		constexpr inline void _Steal(SmallDynamicArray& other) {
+			if (!other.IsInline() && !AllocatorTraits<Allocator>::Equal(_allocator, other._allocator)) {
+				Reserve(other._size);
+				for (uint32_t i = 0; i < other._size; i++) {
+					_allocator.construct(&_pData[i], std::move(other._pData[i]));
+				}
+				_size = other._size;
+				other.Clear();
+				return;
+			}
+			if (other.IsInline()) {
+				Relocate(_allocator, _pData, other._pData, other._size);
+				_size = other._size;
+				other._size = 0;
+				return;
+			}
+			_capacity = other._capacity;
+			_size = other._size;
+			_pData = other._pData;
+			other._capacity = T_inline_capacity;
+			other._size = 0;
+			other._pData = other._InlineData();
+		}
+
+		Allocator _allocator;
+		uint32_t _capacity;
+		uint32_t _size;
+		T* _pData;
+		alignas(T) unsigned char _inlineData[T_inline_capacity * sizeof(T)];
+	};
+}
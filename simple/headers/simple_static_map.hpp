@@ -0,0 +1,189 @@
+#pragma once
+
+#include "simple_hash.hpp"
+#include "simple_tuple.hpp"
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+namespace simple {
+
+	// hash used by simple::StaticSet and simple::StaticMap, string keys use the same hash as simple::String
+	template<typename Key>
+	constexpr inline uint64_t StaticHash(const Key& key) noexcept {
+		if constexpr (std::is_convertible_v<const Key&, std::string_view>) {
+			return HashString(std::string_view(key));
+		}
+		else if constexpr (std::is_enum_v<Key>) {
+			return static_cast<uint64_t>(key);
+		}
+		else {
+			static_assert(std::is_integral_v<Key>, "simple::StaticHash only supports integral, enum and string keys!");
+			return static_cast<uint64_t>(key);
+		}
+	}
+
+	// Perfect hash set of T_count keys known at compile time, which maps each key to its index in the list it was built from.
+	// Built with hash and displace: the keys are grouped into buckets by one hash, then each bucket (largest first) gets a seed
+	// that sends all of its keys to free slots. A lookup is two hashes and one key compare, without probing or heap memory.
+	template<typename Key, size_t T_count>
+	class StaticSet {
+	public:
+
+		static_assert(T_count > 0 && T_count < UINT32_MAX, "invalid simple::StaticSet key count!");
+
+		static constexpr inline size_t table_size = std::bit_ceil(T_count);
+		static constexpr inline uint32_t no_index = UINT32_MAX;
+		static constexpr inline uint32_t max_seed = 1u << 20;
+
+		// keys can be of any type Key is constructible from, e.g. an array of const char* for std::string_view keys
+		template<typename T>
+		consteval StaticSet(const T (&keys)[T_count]) : _keys(), _indices(), _seeds() {
+			_Build([&keys](size_t index) { return Key(keys[index]); });
+		}
+
+		constexpr inline size_t Size() const noexcept {
+			return T_count;
+		}
+
+		// index of key in the list the set was built from, or no_index
+		constexpr inline uint32_t IndexOf(const Key& key) const noexcept {
+			uint64_t hash = StaticHash(key);
+			uint32_t slot = _Slot(hash, _seeds[_Bucket(hash)]);
+			return _indices[slot] != no_index && _keys[slot] == key ? _indices[slot] : no_index;
+		}
+
+		constexpr inline bool Contains(const Key& key) const noexcept {
+			return IndexOf(key) != no_index;
+		}
+
+	private:
+
+		static constexpr inline uint64_t mask = table_size - 1;
+
+		static constexpr inline uint32_t _Bucket(uint64_t hash) noexcept {
+			return static_cast<uint32_t>(HashMix(hash) & mask);
+		}
+
+		static constexpr inline uint32_t _Slot(uint64_t hash, uint32_t seed) noexcept {
+			return static_cast<uint32_t>(HashMix(hash ^ ((seed + 1) * 0x9e3779b97f4a7c15ULL)) & mask);
+		}
+
+		// not constexpr, so reaching it stops compilation with the call in the error message
+		static inline void _DuplicateKey() {}
+		static inline void _NoSeedFound() {}
+
+		template<typename GetKey>
+		constexpr inline void _Build(GetKey getKey) {
+			Key keys[T_count]{};
+			uint64_t hashes[T_count]{};
+			uint32_t buckets[T_count]{};
+			uint32_t bucketSizes[table_size]{};
+			bool used[table_size]{};
+			uint32_t maxBucketSize = 0;
+			for (size_t i = 0; i < T_count; i++) {
+				keys[i] = getKey(i);
+				for (size_t j = 0; j < i; j++) {
+					if (keys[j] == keys[i]) {
+						_DuplicateKey();
+					}
+				}
+				hashes[i] = StaticHash(keys[i]);
+				buckets[i] = _Bucket(hashes[i]);
+				uint32_t size = ++bucketSizes[buckets[i]];
+				maxBucketSize = size > maxBucketSize ? size : maxBucketSize;
+			}
+			for (size_t i = 0; i < table_size; i++) {
+				_indices[i] = no_index;
+			}
+			for (uint32_t size = maxBucketSize; size; size--) {
+				for (uint32_t bucket = 0; bucket < table_size; bucket++) {
+					if (bucketSizes[bucket] != size) {
+						continue;
+					}
+					uint32_t seed = 0;
+					for (;; seed++) {
+						if (seed == max_seed) {
+							_NoSeedFound();
+						}
+						uint32_t slots[T_count]{};
+						uint32_t slotCount = 0;
+						bool fits = true;
+						for (size_t i = 0; i < T_count && fits; i++) {
+							if (buckets[i] != bucket) {
+								continue;
+							}
+							uint32_t slot = _Slot(hashes[i], seed);
+							fits = !used[slot];
+							for (uint32_t j = 0; j < slotCount && fits; j++) {
+								fits = slots[j] != slot;
+							}
+							slots[slotCount++] = slot;
+						}
+						if (fits) {
+							break;
+						}
+					}
+					_seeds[bucket] = seed;
+					for (size_t i = 0; i < T_count; i++) {
+						if (buckets[i] != bucket) {
+							continue;
+						}
+						uint32_t slot = _Slot(hashes[i], seed);
+						used[slot] = true;
+						_keys[slot] = keys[i];
+						_indices[slot] = static_cast<uint32_t>(i);
+					}
+				}
+			}
+		}
+
+		Key _keys[table_size];
+		uint32_t _indices[table_size];
+		uint32_t _seeds[table_size];
+	};
+
+	// Map with T_count entries known at compile time, looked up through a simple::StaticSet of its keys
+	template<typename Key, typename Val, size_t T_count>
+	class StaticMap {
+	public:
+
+		consteval StaticMap(const Tuple<Key, Val> (&entries)[T_count]) : _keys(_Keys(entries).keys), _values() {
+			for (size_t i = 0; i < T_count; i++) {
+				_values[i] = entries[i].second;
+			}
+		}
+
+		constexpr inline size_t Size() const noexcept {
+			return T_count;
+		}
+
+		constexpr inline const Val* Find(const Key& key) const noexcept {
+			uint32_t index = _keys.IndexOf(key);
+			return index != StaticSet<Key, T_count>::no_index ? &_values[index] : nullptr;
+		}
+
+		constexpr inline bool Contains(const Key& key) const noexcept {
+			return _keys.Contains(key);
+		}
+
+	private:
+
+		struct KeyArray {
+			Key keys[T_count];
+		};
+
+		static consteval KeyArray _Keys(const Tuple<Key, Val> (&entries)[T_count]) {
+			KeyArray result{};
+			for (size_t i = 0; i < T_count; i++) {
+				result.keys[i] = entries[i].first;
+			}
+			return result;
+		}
+
+		StaticSet<Key, T_count> _keys;
+		Val _values[T_count];
+	};
+}
@@ -2,194 +2,208 @@
 
 #include "simple_allocator.hpp"
 #include "simple_array.hpp"
+#include "simple_format.hpp"
+#include "simple_hash.hpp"
+#include "simple_simd.hpp"
+#include "simple_string_view.hpp"
 #include <assert.h>
+#include <bit>
 #include <cstdint>
+#include <cstring>
 #include <filesystem>
+#include <string_view>
+#include <type_traits>
 
 namespace simple {
 
-	template<typename Allocator = DynamicAllocator<char>>
+	// Strings up to local_capacity characters are stored inside the object, longer ones are allocated with Allocator.
+	// The last byte of the object tells the two apart: local strings keep local_capacity - length there (which becomes
+	// the null terminator at full length), allocated strings keep heap_tag in the matching byte of their capacity.
+	// T_cache_hash makes the string remember its hash after the first call to hash() (e.g. by a simple::Map lookup),
+	// every member function that can modify the characters forgets it again
+	template<typename Allocator = DynamicAllocator<char>, bool T_cache_hash = false>
 	struct String { 
+	private:
+
+		struct Heap {
+			char* pData;
+			size_t length;
+			size_t capacity;
+		};
+
 	public:
 
 		typedef char* Iterator;
 		typedef const char* ConstIterator;
 
-		inline String() noexcept : _capacity(0), _length(0), _pData(nullptr) {}
+		static constexpr inline size_t local_capacity = sizeof(Heap) - 1;
 
-		inline String(const String& other) : _capacity(other._capacity), _length(other._length), _pData(nullptr) {
-			if (other._capacity != 0) {
-				_pData = getAllocator().allocate(other._capacity);
-				for (size_t i = 0; i < other._length; i++) {
-					_pData[i] = other._pData[i];
-				}
-				_pData[_length] = '\0';
+		inline String() noexcept : _storage(), _hash(), _allocator() {
+			_SetLocalLength(0);
+		}
+
+		explicit inline String(const Allocator& allocator) noexcept : _storage(), _hash(), _allocator(allocator) {
+			_SetLocalLength(0);
+		}
+
+		inline String(const String& other) : String(other, AllocatorTraits<Allocator>::SelectOnCopy(other._allocator)) {}
+
+		inline String(const String& other, const Allocator& allocator) : _storage(), _hash(other._hash), _allocator(allocator) {
+			if (other._IsLocal()) {
+				_storage = other._storage;
+			}
+			else {
+				_SetLocalLength(0);
+				_Assign(other.data(), other.length());
+				_hash = other._hash;
 			}
 		}
 
-		inline String(String&& other) noexcept : _capacity(other._capacity), _length(other._length), _pData(other._pData) {
-			other._capacity = 0;
-			other._length = 0;
-			other._pData = nullptr;
+		inline String(String&& other) noexcept : _storage(other._storage), _hash(other._hash), _allocator(other._allocator) {
+			other._SetLocalLength(0);
+			other._InvalidateHash();
 		}
 
-		inline String(size_t length) : _capacity(length + 1), _length(length), _pData(nullptr) {
-			_pData = getAllocator().allocate(_capacity);
-			_pData[_length] = '\0';
+		inline String(size_t length, const Allocator& allocator = Allocator()) : _storage(), _hash(), _allocator(allocator) {
+			_SetLocalLength(0);
+			reserve(length + 1);
+			_SetLength(length);
 		}
 
-		inline String(char* buffer, size_t length) : _capacity(0), _length(0), _pData(nullptr) {
+		inline String(char* buffer, size_t length, const Allocator& allocator = Allocator()) : _storage(), _hash(), _allocator(allocator) {
+			_SetLocalLength(0);
 			newString(buffer, length);
 		}
 
-		inline String(const char* text) : _capacity(0), _length(0), _pData(nullptr) {
+		inline String(const char* text, const Allocator& allocator = Allocator()) : _storage(), _hash(), _allocator(allocator) {
+			_SetLocalLength(0);
 			newString(text);
 		}
 
-		inline String(const char* text, size_t begin, size_t end) : _capacity(0), _length(0), _pData(nullptr) {
+		inline String(const char* text, size_t begin, size_t end, const Allocator& allocator = Allocator()) : _storage(), _hash(), _allocator(allocator) {
+			_SetLocalLength(0);
 			size_t length = 0;
 			for (size_t i = begin; i < end; i++) {
 				if (text[i] == '\0') {
-					end = i;
 					break;
 				}
 				length++;
 			}
-			reserve(length + 1);
-			for (size_t i = begin; i < end; i++) {
-				append(text[i]);
-			}
+			_Assign(text + begin, length);
 		}
 
-		inline bool empty() {
-			return !_length;
+		explicit inline String(StringView view, const Allocator& allocator = Allocator()) : _storage(), _hash(), _allocator(allocator) {
+			_SetLocalLength(0);
+			_Assign(view.Data(), view.Length());
 		}
 
-		inline Allocator getAllocator() {
-			return Allocator();
+		inline bool empty() const {
+			return !length();
 		}
 
+		inline const Allocator& getAllocator() const noexcept {
+			return _allocator;
+		}
+
+		// bytes available including the null terminator
 		inline size_t capacity() const {
-			return _capacity;
+			return _IsLocal() ? local_capacity + 1 : _DecodeCapacity(_storage.heap.capacity);
 		}
 
 		inline size_t length() const {
-			return _length;
+			return _IsLocal() ? local_capacity - _Tag() : _storage.heap.length;
 		}
 
+		// never null, empty strings point to their local null terminator
 		inline const char* data() const {
-			return _pData;
+			return _IsLocal() ? _storage.local : _storage.heap.pData;
 		}
 
 		inline void reserve(size_t capacity) {
-			if (capacity <= _capacity) {
+			if (capacity <= this->capacity()) {
 				return;
 			}
-			char* temp = getAllocator().allocate(capacity);
-			for (size_t i = 0; i < _length; i++) {
-				temp[i] = _pData[i];
+			if constexpr (ReallocatingAllocator<Allocator, char>) {
+				if (!_IsLocal()) {
+					_storage.heap.pData = _allocator.reallocate(_storage.heap.pData, _DecodeCapacity(_storage.heap.capacity), capacity);
+					_storage.heap.capacity = _EncodeCapacity(capacity);
+					return;
+				}
 			}
-			getAllocator().deallocate(_pData, 1);
-			_pData = temp;
-			_pData[_length] = '\0';
-			_capacity = capacity;
+			size_t length = this->length();
+			char* temp = _allocator.allocate(capacity);
+			std::memcpy(temp, data(), length + 1);
+			_Free();
+			_storage.heap.pData = temp;
+			_storage.heap.length = length;
+			_storage.heap.capacity = _EncodeCapacity(capacity);
 		}
 
 		inline void newString(const char* constChar) {
-			getAllocator().deallocate(_pData, 1);
-			int i = 0;
-			while (constChar[i] != '\0') {
-				i++;
-			}
-			_length = i;
-			_capacity = _length + 1;
-			_pData = getAllocator().allocate(_length + 1);
-			for (int j = 0; j < _length; j++) {
-				_pData[j] = constChar[j];
-			}
-			_pData[_length] = '\0';
+			_Assign(constChar, simd::Length(constChar));
 		}
 
 		void newString(char* buffer, size_t length) {
-			getAllocator().deallocate(_pData, 1);
-			_pData = getAllocator().allocate(length + 1);
-			for (int i = 0; i < length; i++) {
-				_pData[i] = buffer[i];
-			}
-			_pData[length] = '\0';
-			_length = length;
-			_capacity = _length + 1;
+			_Assign(buffer, length);
 		}
 
 		inline String& append(char c) {
-			if (_capacity - _length < 2) {
-				reserve(_capacity ? _capacity + 1 : 2);
+			_InvalidateHash();
+			size_t length = this->length();
+			if (capacity() - length < 2) {
+				_Grow(length + 2);
 			}
-			_pData[_length++] = c;
-			_pData[_length] = '\0';
+			_Data()[length] = c;
+			_SetLength(length + 1);
 			return *this;
 		}
 
+		// appending the string to itself is fine, _Append keeps track of a source inside its own buffer
 		inline String& append(const String& other) {
-			if (_length + other._length + 1 > _capacity) {
-				reserve(_length + other._length + 1);
-			}
-			for (size_t i = 0; i < other._length; i++) {
-				_pData[_length + i] = other._pData[i];
-			}
-			_length += other._length;
-			_pData[_length] = '\0';
-			return *this;
+			return _Append(other.data(), other.length());
 		}
 
 		inline String& append(const char* cStr) {
-			size_t cStrLength = 0;
-			while (cStr[cStrLength] != '\0') {
-				cStrLength++;
-			}
-			if (_length + cStrLength > _capacity) {
-				reserve(_length + cStrLength + 1);
-			}
-			for (size_t i = 0; i < cStrLength; i++) {
-				_pData[_length + i] = cStr[i];
-			}
-			_length += cStrLength;
-			_pData[_length] = '\0';
-			return *this;
+			return _Append(cStr, simd::Length(cStr));
 		}
 
 		inline String subString(size_t begin, size_t end) const {
-			assert(begin < end && begin < _length && end <= _length && "invalid sub string arguments!");
-			String result(end - begin);
-			for (size_t i = begin; i < end; i++) {
-				result._pData[i - begin] = _pData[i];
-			}
-			result._pData[end - begin] = '\0';
+			assert(begin < end && begin < length() && end <= length() && "invalid sub string arguments!");
+			String result(end - begin, _allocator);
+			std::memcpy(result._Data(), data() + begin, end - begin);
 			return result;
 		}
 
+		// same as subString, but without copying the characters
+		inline StringView subView(size_t begin, size_t end) const {
+			assert(begin <= end && end <= length() && "invalid sub view arguments!");
+			return StringView(data() + begin, end - begin);
+		}
+
 		inline void clear() {
-			_capacity = 0;
-			_length = 0;
-			getAllocator().deallocate(_pData, 1);
-			_pData = nullptr;
+			_InvalidateHash();
+			_Free();
+			_SetLocalLength(0);
 		}
 
+		// the characters can be modified through the returned iterator, so a cached hash is forgotten
 		Iterator begin() const noexcept {
-			return &_pData[0];
+			_InvalidateHash();
+			return const_cast<String*>(this)->_Data();
 		}
 
 		ConstIterator end() const noexcept {
-			return &_pData[_length];
+			return data() + length();
 		}
 
 		inline char& operator[](size_t index) const {
-			return _pData[index];
+			_InvalidateHash();
+			return const_cast<String*>(this)->_Data()[index];
 		}
 
 		template<class Element, class Traits>
 		friend inline std::basic_istream<Element, Traits>& operator>>(
-			std::basic_istream<Element, Traits>& istream, String<Allocator>& string) {
+			std::basic_istream<Element, Traits>& istream, String& string) {
 
 			using Istream = std::basic_istream<Element, Traits>;
 			using ctype = typename Istream::_Ctype;
@@ -232,117 +246,267 @@ namespace simple {
 		}	
 
 		inline bool operator==(const String& other) const {
-			if (!_pData || !other._pData) {
+			size_t length = this->length();
+			if (length != other.length()) {
 				return false;
 			}
-			return !strcmp(_pData, other._pData);
+			if constexpr (T_cache_hash) {
+				if (_hash && other._hash && _hash != other._hash) {
+					return false;
+				}
+			}
+			return simd::Equal(data(), other.data(), length);
 		}
 
 		inline bool operator==(const char* other) const {
-			if (!_pData) {
-				return false;
-			}
-			return !strcmp(_pData, other);
+			size_t length = this->length();
+			return simd::Length(other) == length && simd::Equal(data(), other, length);
+		}
+
+		inline bool operator==(std::string_view other) const {
+			return length() == other.length() && simd::Equal(data(), other.data(), other.length());
+		}
+
+		inline bool operator==(StringView other) const {
+			return *this == std::string_view(other);
 		}
 
 		inline String& operator=(const String& other) {
-			getAllocator().deallocate(_pData, 1);
-			_length = other._length;
-			_capacity = _length + 1;
-			_pData = getAllocator().allocate(_capacity);
-			for (int i = 0; i < _length; i++) {
-				_pData[i] = other._pData[i];
-			}
-			_pData[_length] = '\0';
+			if (this == &other) {
+				return *this;
+			}
+			if constexpr (AllocatorTraits<Allocator>::propagate_on_copy) {
+				if (!AllocatorTraits<Allocator>::Equal(_allocator, other._allocator)) {
+					_Free();
+				}
+				_allocator = other._allocator;
+			}
+			if (other._IsLocal()) {
+				_Free();
+				_storage = other._storage;
+			}
+			else {
+				_Assign(other.data(), other.length());
+			}
+			_hash = other._hash;
 			return *this;
 		}
 
-		inline bool operator<(const String& other) const {
-			if (!_pData || !other._pData) {
-				return false;
+		inline String& operator=(String&& other) noexcept(AllocatorTraits<Allocator>::propagate_on_move || AllocatorTraits<Allocator>::always_equal) {
+			if (this == &other) {
+				return *this;
 			}
-			size_t i = 0;
-			while ((_pData[i] != '\0' || other._pData[i] != '\0') && _pData[i] == other._pData[i]) {
-				i++;
+			if constexpr (AllocatorTraits<Allocator>::propagate_on_move) {
+				_Free();
+				_allocator = other._allocator;
 			}
-			return _pData[i] < other._pData[i];
+			else if (!other._IsLocal() && !AllocatorTraits<Allocator>::Equal(_allocator, other._allocator)) {
+				// the characters have to be copied into memory of this string's allocator
+				_Assign(other.data(), other.length());
+				_hash = other._hash;
+				other.clear();
+				return *this;
+			}
+			_Free();
+			_storage = other._storage;
+			_hash = other._hash;
+			other._SetLocalLength(0);
+			other._InvalidateHash();
+			return *this;
+		}
+
+		inline bool operator<(const String& other) const {
+			// comparing one past the shorter length includes its null terminator
+			size_t length = this->length() < other.length() ? this->length() : other.length();
+			size_t i = simd::Mismatch(data(), other.data(), length + 1);
+			return i <= length && data()[i] < other.data()[i];
 		}
 
 		inline friend String operator+(const String& a, const String& b) {
-			String result{};
-			result.reserve(a._length + b._length);
+			String result(a._allocator);
+			result.reserve(a.length() + b.length() + 1);
 			result.append(a).append(b);
 			return result;
 		}
 
 		inline friend String operator+(const String& a, const char* b) {
-			size_t bLength = SIZE_MAX;
-			for (size_t i = 0; i < bLength; i++) {
-				if (b[i] == '\0') {
-					bLength = i;
-					break;
-				}
-			}
-			simple::String<> result{};
-			result.reserve(a.length() + bLength);
-			for (char c : a) {
-				result.append(c);
-			}
-			for (size_t i = 0; i < bLength; i++) {
-				result.append(b[i]);
-			}
+			size_t bLength = simd::Length(b);
+			String result(a._allocator);
+			result.reserve(a.length() + bLength + 1);
+			result.append(a)._Append(b, bLength);
 			return result;
 		}
 
 		inline friend String operator+(const char* a, const String& b) {
-			size_t aLength = SIZE_MAX;
-			for (size_t i = 0; i < aLength; i++) {
-				if (a[i] == '\0') {
-					aLength = i;
-					break;
+			size_t aLength = simd::Length(a);
+			String result(b._allocator);
+			result.reserve(aLength + b.length() + 1);
+			result._Append(a, aLength).append(b);
+			return result;
+		}
+
+		inline uint64_t hash() const noexcept {
+			if constexpr (T_cache_hash) {
+				if (!_hash) {
+					uint64_t hash = HashBytes(data(), length());
+					// 0 marks a hash that isn't cached
+					_hash = hash ? hash : 1;
 				}
+				return _hash;
 			}
-			simple::String<> result{};
-			result.reserve(aLength + b.length());
-			for (size_t i = 0; i < aLength; i++) {
-				result.append(a[i]);
+			else {
+				return HashBytes(data(), length());
 			}
-			for (char c : b) {
-				result.append(c);
-			}
-			return result;
 		}
 
+		// transparent, so maps and sets keyed by simple::String can be searched with a const char*, std::string_view or simple::StringView without allocating
 		struct Hash {
+
+			typedef void is_transparent;
+
 			inline size_t operator()(const String& string) const {
-				uint64_t h = 37;
-				for (char c : string) {
-					h = (h * 54059) ^ ((uint64_t)c * 76963);
-				}
-				return h;
+				return string.hash();
+			}
+
+			inline size_t operator()(const char* string) const {
+				return HashBytes(string, simd::Length(string));
+			}
+
+			inline size_t operator()(std::string_view string) const {
+				return HashBytes(string.data(), string.length());
+			}
+
+			inline size_t operator()(StringView string) const {
+				return HashBytes(string.Data(), string.Length());
 			}
 		};
 
 		inline ~String() {
-			_capacity = 0;
-			_length = 0;
-			getAllocator().deallocate(_pData, 1);
-			_pData = nullptr;
+			_Free();
 		}
 
 	private:
-		size_t _capacity;
-		size_t _length;
-		char* _pData;
+
+		union Storage {
+			Heap heap;
+			char local[local_capacity + 1];
+		};
+
+		static constexpr inline unsigned char heap_tag = 0x80;
+		static constexpr inline size_t tag_shift = (sizeof(size_t) - 1) * 8;
+
+		struct NoHash {};
+
+		// puts heap_tag in the byte of the capacity that overlaps the last local character
+		static constexpr inline size_t _EncodeCapacity(size_t capacity) noexcept {
+			if constexpr (std::endian::native == std::endian::little) {
+				assert(!(capacity >> tag_shift) && "string capacity too large (function simple::String::reserve)!");
+				return capacity | (static_cast<size_t>(heap_tag) << tag_shift);
+			}
+			else {
+				return capacity << 8 | heap_tag;
+			}
+		}
+
+		static constexpr inline size_t _DecodeCapacity(size_t capacity) noexcept {
+			if constexpr (std::endian::native == std::endian::little) {
+				return capacity & ~(static_cast<size_t>(0xff) << tag_shift);
+			}
+			else {
+				return capacity >> 8;
+			}
+		}
+
+		inline unsigned char _Tag() const noexcept {
+			return static_cast<unsigned char>(_storage.local[local_capacity]);
+		}
+
+		inline bool _IsLocal() const noexcept {
+			return !(_Tag() & heap_tag);
+		}
+
+		inline char* _Data() noexcept {
+			return _IsLocal() ? _storage.local : _storage.heap.pData;
+		}
+
+		inline void _SetLocalLength(size_t length) noexcept {
+			_storage.local[length] = '\0';
+			_storage.local[local_capacity] = static_cast<char>(local_capacity - length);
+		}
+
+		inline void _SetLength(size_t length) noexcept {
+			if (_IsLocal()) {
+				_SetLocalLength(length);
+			}
+			else {
+				_storage.heap.length = length;
+				_storage.heap.pData[length] = '\0';
+			}
+		}
+
+		inline void _Free() {
+			if (!_IsLocal()) {
+				_allocator.deallocate(_storage.heap.pData, _DecodeCapacity(_storage.heap.capacity));
+				_SetLocalLength(0);
+			}
+		}
+
+		// appends grow the capacity geometrically, so building a string a character at a time stays linear
+		inline void _Grow(size_t required) {
+			size_t capacity = this->capacity() * 2;
+			reserve(capacity > required ? capacity : required);
+		}
+
+		inline void _Assign(const char* str, size_t length) {
+			_InvalidateHash();
+			if (length + 1 > capacity()) {
+				_Free();
+				reserve(length + 1);
+			}
+			std::memmove(_Data(), str, length);
+			_SetLength(length);
+		}
+
+		inline String& _Append(const char* str, size_t length) {
+			_InvalidateHash();
+			size_t oldLength = this->length();
+			if (oldLength + length + 1 > capacity()) {
+				// str may point into this string, growing frees the buffer it points to
+				const char* data = _Data();
+				bool aliased = str >= data && str < data + capacity();
+				size_t offset = str - data;
+				_Grow(oldLength + length + 1);
+				if (aliased) {
+					str = _Data() + offset;
+				}
+			}
+			std::memcpy(_Data() + oldLength, str, length);
+			_SetLength(oldLength + length);
+			return *this;
+		}
+
+		constexpr inline void _InvalidateHash() const noexcept {
+			if constexpr (T_cache_hash) {
+				_hash = 0;
+			}
+		}
+
+		Storage _storage;
+		[[no_unique_address]] mutable std::conditional_t<T_cache_hash, uint64_t, NoHash> _hash;
+		[[no_unique_address]] Allocator _allocator;
 	};
 
-	inline simple::String<> toString(uint64_t unsignedInt) {
-		char buffer[21];
-		buffer[20] = '0' + unsignedInt % 10;
-		size_t i = 20;
-		while (unsignedInt /= 10) {
-			buffer[--i] = '0' + unsignedInt % 10;
+	// integers and floats (shortest representation that reads back to the same value), usually fits in the local storage
+	template<typename T> requires std::is_arithmetic_v<T> && (!std::is_same_v<T, bool>)
+	inline simple::String<> toString(T value) {
+		char buffer[max_float_chars];
+		size_t length;
+		if constexpr (std::is_floating_point_v<T>) {
+			length = FormatFloat(buffer, sizeof(buffer), value);
+		}
+		else {
+			length = FormatInt(buffer, sizeof(buffer), value);
 		}
-		return simple::String<>(buffer, i, 21);
+		return simple::String<>(buffer, length);
 	}
 }
@@ -0,0 +1,164 @@
+#pragma once
+
+#include "simple_allocator.hpp"
+#include "simple_dynamic_array.hpp"
+#include "simple_format.hpp"
+#include "simple_string.hpp"
+#include <assert.h>
+#include <charconv>
+#include <concepts>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace simple {
+
+	// Accumulates string fragments and numbers into chunks that are never moved while building, then produces the
+	// finished simple::String with a single allocation (or none, if it fits in the string's local storage).
+	// The first T_local_size characters are stored inside the builder, every further chunk is twice as large as the last.
+	template<typename Allocator = DynamicAllocator<char>, size_t T_local_size = 256>
+	class StringBuilder {
+	public:
+
+		static_assert(T_local_size > 0, "simple::StringBuilder local size must be greater than zero!");
+
+		inline StringBuilder() noexcept : _allocator(), _chunks(), _length(0), _localSize(0) {}
+
+		// the chunks and the finished string are allocated with allocator
+		explicit inline StringBuilder(const Allocator& allocator) noexcept : _allocator(allocator), _chunks(), _length(0), _localSize(0) {}
+
+		StringBuilder(const StringBuilder&) = delete;
+		StringBuilder(StringBuilder&&) = delete;
+
+		inline size_t Length() const noexcept {
+			return _length;
+		}
+
+		inline StringBuilder& Append(std::string_view string) {
+			const char* src = string.data();
+			size_t remaining = string.length();
+			_length += remaining;
+			if (_localSize < T_local_size) {
+				size_t count = T_local_size - _localSize < remaining ? T_local_size - _localSize : remaining;
+				std::memcpy(_local + _localSize, src, count);
+				_localSize += count;
+				src += count;
+				remaining -= count;
+			}
+			if (!remaining) {
+				return *this;
+			}
+			if (_chunks.Size()) {
+				Chunk& chunk = *_chunks.Back();
+				size_t count = chunk.capacity - chunk.size < remaining ? chunk.capacity - chunk.size : remaining;
+				std::memcpy(chunk.pData + chunk.size, src, count);
+				chunk.size += count;
+				src += count;
+				remaining -= count;
+			}
+			if (remaining) {
+				size_t capacity = _chunks.Size() ? _chunks.Back()->capacity * 2 : T_local_size * 2;
+				capacity = capacity > remaining ? capacity : remaining;
+				char* pData = _allocator.allocate(capacity);
+				assert(pData && "failed to allocate memory (function simple::StringBuilder::Append)!");
+				std::memcpy(pData, src, remaining);
+				_chunks.PushBack(Chunk{ pData, remaining, capacity });
+			}
+			return *this;
+		}
+
+		inline StringBuilder& Append(const char* string) {
+			return Append(std::string_view(string));
+		}
+
+		template<typename StringAllocator, bool T_cache_hash>
+		inline StringBuilder& Append(const String<StringAllocator, T_cache_hash>& string) {
+			return Append(std::string_view(string.data(), string.length()));
+		}
+
+		inline StringBuilder& Append(char c) {
+			return Append(std::string_view(&c, 1));
+		}
+
+		inline StringBuilder& Append(bool value) {
+			return Append(value ? std::string_view("true") : std::string_view("false"));
+		}
+
+		template<std::integral T>
+		inline StringBuilder& Append(T value) {
+			char buffer[max_int_chars];
+			return Append(std::string_view(buffer, FormatInt(buffer, sizeof(buffer), value)));
+		}
+
+		// shortest representation that reads back to the same value
+		template<std::floating_point T>
+		inline StringBuilder& Append(T value) {
+			char buffer[max_float_chars];
+			return Append(std::string_view(buffer, FormatFloat(buffer, sizeof(buffer), value)));
+		}
+
+		// value with a fixed number of digits after the decimal point, precision is clamped to 17
+		template<std::floating_point T>
+		inline StringBuilder& Append(T value, int precision) {
+			char buffer[64];
+			precision = precision < 0 ? 0 : precision > 17 ? 17 : precision;
+			size_t length = FormatFloat(buffer, sizeof(buffer), value, precision);
+			if (!length) {
+				std::to_chars_result result = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::scientific, precision);
+				length = result.ptr - buffer;
+			}
+			return Append(std::string_view(buffer, length));
+		}
+
+		// lowercase hex digits without a prefix, padded with zeros to at least minDigits
+		template<std::integral T>
+		inline StringBuilder& AppendHex(T value, uint32_t minDigits = 1) {
+			char buffer[max_int_chars];
+			minDigits = minDigits < max_int_chars ? minDigits : max_int_chars;
+			return Append(std::string_view(buffer, FormatHex(buffer, sizeof(buffer), value, minDigits)));
+		}
+
+		template<bool T_cache_hash = false>
+		inline String<Allocator, T_cache_hash> ToString() const {
+			String<Allocator, T_cache_hash> result(_length, _allocator);
+			if (!_length) {
+				return result;
+			}
+			char* dst = result.begin();
+			std::memcpy(dst, _local, _localSize);
+			dst += _localSize;
+			for (const Chunk& chunk : _chunks) {
+				std::memcpy(dst, chunk.pData, chunk.size);
+				dst += chunk.size;
+			}
+			return result;
+		}
+
+		inline void Clear() {
+			for (Chunk& chunk : _chunks) {
+				_allocator.deallocate(chunk.pData, chunk.capacity);
+			}
+			_chunks.Clear();
+			_length = 0;
+			_localSize = 0;
+		}
+
+		inline ~StringBuilder() {
+			Clear();
+		}
+
+	private:
+
+		struct Chunk {
+			char* pData;
+			size_t size;
+			size_t capacity;
+		};
+
+		Allocator _allocator;
+		DynamicArray<Chunk> _chunks;
+		size_t _length;
+		size_t _localSize;
+		char _local[T_local_size];
+	};
+}
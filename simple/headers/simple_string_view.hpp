@@ -0,0 +1,336 @@
+#pragma once
+
+#include "simple_hash.hpp"
+#include "simple_simd.hpp"
+#include <assert.h>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace simple {
+
+	// Non-owning pointer and length into characters owned by something else (a simple::String, a file buffer, a literal).
+	// Views are not null terminated, the characters have to outlive the view.
+	// Hashes the same way as simple::String, so views can be used as keys or to search maps and sets keyed by strings.
+	class StringView {
+	public:
+
+		typedef const char* Iterator;
+		typedef const char* ConstIterator;
+
+		static constexpr inline size_t npos = SIZE_MAX;
+
+		constexpr inline StringView() noexcept : _pData(nullptr), _length(0) {}
+
+		constexpr inline StringView(const char* data, size_t length) noexcept : _pData(data), _length(length) {}
+
+		constexpr inline StringView(const char* string) noexcept
+			: _pData(string), _length(std::is_constant_evaluated() ? std::char_traits<char>::length(string) : simd::Length(string)) {}
+
+		constexpr inline StringView(std::string_view string) noexcept : _pData(string.data()), _length(string.length()) {}
+
+		// any string type with data() and length(), e.g. simple::String
+		template<typename T>
+			requires (!std::convertible_to<const T&, const char*>) && requires(const T& string) {
+				{ string.data() } -> std::convertible_to<const char*>;
+				{ string.length() } -> std::convertible_to<size_t>;
+			}
+		constexpr inline StringView(const T& string) noexcept : _pData(string.data()), _length(string.length()) {}
+
+		constexpr inline operator std::string_view() const noexcept {
+			return std::string_view(_pData, _length);
+		}
+
+		constexpr inline const char* Data() const noexcept {
+			return _pData;
+		}
+
+		constexpr inline size_t Length() const noexcept {
+			return _length;
+		}
+
+		constexpr inline bool Empty() const noexcept {
+			return !_length;
+		}
+
+		constexpr inline ConstIterator begin() const noexcept {
+			return _pData;
+		}
+
+		constexpr inline ConstIterator end() const noexcept {
+			return _pData + _length;
+		}
+
+		constexpr inline char operator[](size_t index) const noexcept {
+			assert(index < _length && "index out of bounds (function simple::StringView::operator[])!");
+			return _pData[index];
+		}
+
+		// characters [begin, end), end is clamped to the length
+		constexpr inline StringView SubView(size_t begin, size_t end = npos) const noexcept {
+			end = end < _length ? end : _length;
+			assert(begin <= end && "invalid sub view arguments (function simple::StringView::SubView)!");
+			return StringView(_pData + begin, end - begin);
+		}
+
+		// index of the first c at or after from, or npos
+		constexpr inline size_t Find(char c, size_t from = 0) const noexcept {
+			if (!std::is_constant_evaluated()) {
+				if (from >= _length) {
+					return npos;
+				}
+				size_t index = simd::FindChar(_pData + from, _length - from, c);
+				return index == npos ? npos : from + index;
+			}
+			for (size_t i = from; i < _length; i++) {
+				if (_pData[i] == c) {
+					return i;
+				}
+			}
+			return npos;
+		}
+
+		constexpr inline size_t Find(StringView string, size_t from = 0) const noexcept {
+			if (string._length > _length) {
+				return npos;
+			}
+			if (!std::is_constant_evaluated()) {
+				if (from > _length) {
+					return npos;
+				}
+				size_t index = simd::FindString(_pData + from, _length - from, string._pData, string._length);
+				return index == npos ? npos : from + index;
+			}
+			for (size_t i = from; i + string._length <= _length; i++) {
+				if (StringView(_pData + i, string._length) == string) {
+					return i;
+				}
+			}
+			return npos;
+		}
+
+		constexpr inline size_t FindLast(char c) const noexcept {
+			for (size_t i = _length; i > 0; i--) {
+				if (_pData[i - 1] == c) {
+					return i - 1;
+				}
+			}
+			return npos;
+		}
+
+		// index of the first character that's in chars, or npos
+		constexpr inline size_t FindAny(StringView chars, size_t from = 0) const noexcept {
+			for (size_t i = from; i < _length; i++) {
+				if (chars.Find(_pData[i]) != npos) {
+					return i;
+				}
+			}
+			return npos;
+		}
+
+		constexpr inline bool Contains(StringView string) const noexcept {
+			return Find(string) != npos;
+		}
+
+		constexpr inline bool StartsWith(StringView prefix) const noexcept {
+			return prefix._length <= _length && StringView(_pData, prefix._length) == prefix;
+		}
+
+		constexpr inline bool EndsWith(StringView suffix) const noexcept {
+			return suffix._length <= _length && StringView(_pData + _length - suffix._length, suffix._length) == suffix;
+		}
+
+		constexpr inline StringView TrimLeft() const noexcept {
+			size_t begin = 0;
+			while (begin < _length && IsSpace(_pData[begin])) {
+				begin++;
+			}
+			return StringView(_pData + begin, _length - begin);
+		}
+
+		constexpr inline StringView TrimRight() const noexcept {
+			size_t length = _length;
+			while (length && IsSpace(_pData[length - 1])) {
+				length--;
+			}
+			return StringView(_pData, length);
+		}
+
+		// without leading and trailing whitespace
+		constexpr inline StringView Trim() const noexcept {
+			return TrimLeft().TrimRight();
+		}
+
+		// splits off the part before the first delimiter and advances the view past the delimiter,
+		// if there is no delimiter left the whole view is returned and the view becomes empty
+		constexpr inline StringView SplitFirst(char delimiter) noexcept {
+			size_t index = Find(delimiter);
+			StringView result = SubView(0, index);
+			*this = index == npos ? StringView(_pData + _length, 0) : SubView(index + 1);
+			return result;
+		}
+
+		// range over the parts between delimiters (empty parts included, like a csv field list)
+		class SplitRange;
+
+		constexpr inline SplitRange Split(char delimiter) const noexcept;
+
+		constexpr inline bool operator==(StringView other) const noexcept {
+			if (_length != other._length) {
+				return false;
+			}
+			if (std::is_constant_evaluated()) {
+				for (size_t i = 0; i < _length; i++) {
+					if (_pData[i] != other._pData[i]) {
+						return false;
+					}
+				}
+				return true;
+			}
+			return simd::Equal(_pData, other._pData, _length);
+		}
+
+		constexpr inline bool operator<(StringView other) const noexcept {
+			size_t length = _length < other._length ? _length : other._length;
+			for (size_t i = 0; i < length; i++) {
+				if (_pData[i] != other._pData[i]) {
+					return static_cast<unsigned char>(_pData[i]) < static_cast<unsigned char>(other._pData[i]);
+				}
+			}
+			return _length < other._length;
+		}
+
+		constexpr inline uint64_t hash() const noexcept {
+			return HashString(*this);
+		}
+
+		// transparent, so maps and sets keyed by views can be searched with a const char* or std::string_view
+		struct Hash {
+
+			typedef void is_transparent;
+
+			constexpr inline size_t operator()(StringView string) const noexcept {
+				return string.hash();
+			}
+
+			constexpr inline size_t operator()(const char* string) const noexcept {
+				return StringView(string).hash();
+			}
+
+			constexpr inline size_t operator()(std::string_view string) const noexcept {
+				return StringView(string).hash();
+			}
+		};
+
+		static constexpr inline bool IsSpace(char c) noexcept {
+			return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+		}
+
+	private:
+
+		const char* _pData;
+		size_t _length;
+	};
+
+	class StringView::SplitRange {
+	public:
+
+		class Iterator {
+		public:
+
+			constexpr inline Iterator(StringView rest, char delimiter, bool end) noexcept
+				: _rest(rest), _current(), _delimiter(delimiter), _end(end) {
+				if (!_end) {
+					_current = _rest.SplitFirst(_delimiter);
+				}
+			}
+
+			constexpr inline StringView operator*() const noexcept {
+				return _current;
+			}
+
+			constexpr inline Iterator& operator++() noexcept {
+				// the view only points past the end once the last part has been split off
+				if (_rest.Data() == _current.end()) {
+					_end = true;
+				}
+				else {
+					_current = _rest.SplitFirst(_delimiter);
+				}
+				return *this;
+			}
+
+			constexpr inline bool operator!=(const Iterator& other) const noexcept {
+				return _end != other._end;
+			}
+
+		private:
+
+			StringView _rest;
+			StringView _current;
+			char _delimiter;
+			bool _end;
+		};
+
+		constexpr inline SplitRange(StringView string, char delimiter) noexcept : _string(string), _delimiter(delimiter) {}
+
+		constexpr inline Iterator begin() const noexcept {
+			return Iterator(_string, _delimiter, false);
+		}
+
+		constexpr inline Iterator end() const noexcept {
+			return Iterator(_string, _delimiter, true);
+		}
+
+	private:
+
+		StringView _string;
+		char _delimiter;
+	};
+
+	constexpr inline StringView::SplitRange StringView::Split(char delimiter) const noexcept {
+		return SplitRange(*this, delimiter);
+	}
+
+	// Splits a view into tokens separated by any of the delimiter characters, skipping empty tokens
+	// (e.g. words separated by runs of whitespace). Next hands out views into the source, nothing is copied.
+	class Tokenizer {
+	public:
+
+		static constexpr inline const char* whitespace = " \t\n\r\v\f";
+
+		constexpr inline Tokenizer(StringView source, StringView delimiters = whitespace) noexcept
+			: _rest(source), _delimiters(delimiters) {}
+
+		// false once there are no tokens left
+		constexpr inline bool Next(StringView& token) noexcept {
+			size_t begin = 0;
+			while (begin < _rest.Length() && _delimiters.Find(_rest[begin]) != StringView::npos) {
+				begin++;
+			}
+			if (begin == _rest.Length()) {
+				_rest = StringView(_rest.end(), 0);
+				return false;
+			}
+			size_t end = _rest.FindAny(_delimiters, begin);
+			end = end == StringView::npos ? _rest.Length() : end;
+			token = _rest.SubView(begin, end);
+			_rest = _rest.SubView(end);
+			return true;
+		}
+
+		// everything after the last token handed out
+		constexpr inline StringView Rest() const noexcept {
+			return _rest;
+		}
+
+	private:
+
+		StringView _rest;
+		StringView _delimiters;
+	};
+}
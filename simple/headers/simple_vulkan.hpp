@@ -2,6 +2,8 @@
 
 #include "vulkan/vulkan.h"
 #include "simple_macros.hpp"
+#include "simple_dynamic_array.hpp"
+#include "simple_small_dynamic_array.hpp"
 
 namespace simple {
 	namespace vulkan {
@@ -12,12 +14,12 @@ namespace simple {
 			VkPhysicalDeviceFeatures vkPhysicalDeviceFeatures;
 			VkPhysicalDeviceProperties vkPhysicalDeviceProperties;
 			DynamicArray<VkExtensionProperties> vkExtensionProperties{};
-			DynamicArray<VkQueueFamilyProperties> vkQueueFamilyProperties{};
+			SmallDynamicArray<VkQueueFamilyProperties, 8> vkQueueFamilyProperties{};
 			uint32_t graphicsQueueFamilyIndex{}, transferQueueFamilyIndex{}, presentQueueFamilyIndex{};
 			bool graphicsQueueFound{}, transferQueueFound{}, presentQueueFound{};
 			VkSurfaceCapabilitiesKHR vkSurfaceCapabilitiesKHR;
-			DynamicArray<VkSurfaceFormatKHR> vkSurfaceFormatsKHR{};
-			DynamicArray<VkPresentModeKHR> vkPresentModesKHR{};
+			SmallDynamicArray<VkSurfaceFormatKHR, 8> vkSurfaceFormatsKHR{};
+			SmallDynamicArray<VkPresentModeKHR, 4> vkPresentModesKHR{};
 
 			inline PhysicalDeviceInfo() noexcept {}
 
@@ -29,24 +31,24 @@ namespace simple {
 
 				uint32_t vkExtensionPropertiesCount;
 				vkEnumerateDeviceExtensionProperties(vkPhysicalDevice, nullptr, &vkExtensionPropertiesCount, nullptr);
-				vkExtensionProperties.Resize(vkExtensionPropertiesCount);
+				vkExtensionProperties.ResizeUninitialized(vkExtensionPropertiesCount);
 				vkEnumerateDeviceExtensionProperties(vkPhysicalDevice, nullptr, &vkExtensionPropertiesCount, vkExtensionProperties.Data());
 
 				uint32_t vkQueueFamilyPropertiesCount;
 				vkGetPhysicalDeviceQueueFamilyProperties(vkPhysicalDevice, &vkQueueFamilyPropertiesCount, nullptr);
-				vkQueueFamilyProperties.Resize(vkQueueFamilyPropertiesCount);
+				vkQueueFamilyProperties.ResizeUninitialized(vkQueueFamilyPropertiesCount);
 				vkGetPhysicalDeviceQueueFamilyProperties(vkPhysicalDevice, &vkQueueFamilyPropertiesCount, vkQueueFamilyProperties.Data());
 
 				vkGetPhysicalDeviceSurfaceCapabilitiesKHR(vkPhysicalDevice, vkSurfaceKHR, &vkSurfaceCapabilitiesKHR);
 
 				uint32_t vkSurfaceFormatsCount;
 				vkGetPhysicalDeviceSurfaceFormatsKHR(vkPhysicalDevice, vkSurfaceKHR, &vkSurfaceFormatsCount, nullptr);
-				vkSurfaceFormatsKHR.Resize(vkSurfaceFormatsCount);
+				vkSurfaceFormatsKHR.ResizeUninitialized(vkSurfaceFormatsCount);
 				vkGetPhysicalDeviceSurfaceFormatsKHR(vkPhysicalDevice, vkSurfaceKHR, &vkSurfaceFormatsCount, vkSurfaceFormatsKHR.Data());
 
 				uint32_t vkPresentModesCount;
 				vkGetPhysicalDeviceSurfacePresentModesKHR(vkPhysicalDevice, vkSurfaceKHR, &vkPresentModesCount, nullptr);
-				vkPresentModesKHR.Resize(vkPresentModesCount);
+				vkPresentModesKHR.ResizeUninitialized(vkPresentModesCount);
 				vkGetPhysicalDeviceSurfacePresentModesKHR(vkPhysicalDevice, vkSurfaceKHR, &vkPresentModesCount, vkPresentModesKHR.Data());
 
 				uint32_t queueFamilyIndex = 0;
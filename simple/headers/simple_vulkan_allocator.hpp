@@ -0,0 +1,206 @@
+#pragma once
+
+#include "vulkan/vulkan.h"
+#include "simple_allocation_tracker.hpp"
+#include "simple_logging.hpp"
+#include "simple_pool_allocator.hpp"
+#include <assert.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+namespace simple {
+
+	namespace allocation_tags {
+
+		struct VulkanHost {
+			static constexpr inline const char* name = "Vulkan host";
+		};
+	}
+
+	namespace vulkan {
+
+		// VkAllocationCallbacks that route the driver's host allocations through the engine allocators and count them per
+		// VkSystemAllocationScope. Small command and object scope allocations (the short lived and frequent ones) come from the
+		// thread local pools of simple::PoolHeap, everything else (cache, device and instance scope and anything large or over
+		// aligned) from the system heap with the requested alignment. Every allocation is preceded by a header that remembers
+		// where it came from, since vulkan doesn't pass the size back on free. Must outlive every object created with it.
+		class HostAllocator {
+		public:
+
+			static constexpr inline uint32_t scope_count = VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE + 1;
+
+			struct ScopeStats {
+				uint64_t allocationCount;
+				uint64_t liveBytes;
+				uint64_t peakBytes;
+				// memory the driver allocated itself and only reported (e.g. executable memory)
+				uint64_t internalBytes;
+			};
+
+			inline HostAllocator() noexcept : _callbacks{}, _scopes{} {
+				_callbacks.pUserData = this;
+				_callbacks.pfnAllocation = _Allocate;
+				_callbacks.pfnReallocation = _Reallocate;
+				_callbacks.pfnFree = _Free;
+				_callbacks.pfnInternalAllocation = _InternalAllocation;
+				_callbacks.pfnInternalFree = _InternalFree;
+			}
+
+			HostAllocator(const HostAllocator&) = delete;
+			HostAllocator(HostAllocator&&) = delete;
+
+			inline const VkAllocationCallbacks* GetCallbacks() const noexcept {
+				return &_callbacks;
+			}
+
+			inline ScopeStats GetStats(VkSystemAllocationScope scope) const noexcept {
+				assert(scope < scope_count && "invalid allocation scope (function simple::vulkan::HostAllocator::GetStats)!");
+				const Scope& counters = _scopes[scope];
+				return ScopeStats{
+					.allocationCount = counters.allocationCount.load(std::memory_order_relaxed),
+					.liveBytes = counters.liveBytes.load(std::memory_order_relaxed),
+					.peakBytes = counters.peakBytes.load(std::memory_order_relaxed),
+					.internalBytes = counters.internalBytes.load(std::memory_order_relaxed),
+				};
+			}
+
+			inline ~HostAllocator() {
+				for (uint32_t i = 0; i < scope_count; i++) {
+					if (_scopes[i].liveBytes.load(std::memory_order_relaxed)) {
+						logWarning(this, "vulkan host memory was still allocated when simple::vulkan::HostAllocator was destroyed!");
+						break;
+					}
+				}
+			}
+
+		private:
+
+			static constexpr inline uint8_t heap_class = 0xff;
+
+			// sits right in front of every allocation
+			struct alignas(16) Header {
+				size_t size;
+				// from the start of the pool cell or heap block to the allocation
+				uint32_t offset;
+				uint8_t scope;
+				uint8_t sizeClass;
+			};
+
+			struct Scope {
+				std::atomic<uint64_t> allocationCount;
+				std::atomic<uint64_t> liveBytes;
+				std::atomic<uint64_t> peakBytes;
+				std::atomic<uint64_t> internalBytes;
+			};
+
+			static inline Header* _HeaderOf(void* ptr) noexcept {
+				return static_cast<Header*>(ptr) - 1;
+			}
+
+			inline void _Count(VkSystemAllocationScope scope, size_t size) noexcept {
+				Scope& counters = _scopes[scope < scope_count ? scope : 0];
+				counters.allocationCount.fetch_add(1, std::memory_order_relaxed);
+				uint64_t live = counters.liveBytes.fetch_add(size, std::memory_order_relaxed) + size;
+				uint64_t peak = counters.peakBytes.load(std::memory_order_relaxed);
+				while (live > peak && !counters.peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+				AllocationTracker::RecordAllocation(AllocationTracker::TagId<allocation_tags::VulkanHost>(), size);
+			}
+
+			inline void _Uncount(uint8_t scope, size_t size) noexcept {
+				_scopes[scope].liveBytes.fetch_sub(size, std::memory_order_relaxed);
+				AllocationTracker::RecordDeallocation(AllocationTracker::TagId<allocation_tags::VulkanHost>(), size);
+			}
+
+			inline void* _AllocateAligned(size_t size, size_t alignment, VkSystemAllocationScope scope) {
+				alignment = alignment > alignof(Header) ? alignment : alignof(Header);
+				bool pooled = (scope == VK_SYSTEM_ALLOCATION_SCOPE_COMMAND || scope == VK_SYSTEM_ALLOCATION_SCOPE_OBJECT)
+					&& alignment <= PoolHeap::cell_alignment && size + sizeof(Header) <= PoolHeap::max_cell_size;
+				char* block;
+				char* ptr;
+				uint8_t sizeClass;
+				if (pooled) {
+					sizeClass = static_cast<uint8_t>(PoolHeap::SizeClass(size + sizeof(Header)));
+					block = static_cast<char*>(PoolHeap::Allocate(sizeClass));
+					ptr = block + sizeof(Header);
+				}
+				else {
+					sizeClass = heap_class;
+					block = static_cast<char*>(std::malloc(size + sizeof(Header) + alignment - 1));
+					if (!block) {
+						return nullptr;
+					}
+					ptr = reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(block) + sizeof(Header) + alignment - 1) & ~(uintptr_t)(alignment - 1));
+				}
+				Header* header = _HeaderOf(ptr);
+				header->size = size;
+				header->offset = static_cast<uint32_t>(ptr - block);
+				header->scope = static_cast<uint8_t>(scope < scope_count ? scope : 0);
+				header->sizeClass = sizeClass;
+				_Count(scope, size);
+				return ptr;
+			}
+
+			inline void _FreeAligned(void* ptr) noexcept {
+				Header* header = _HeaderOf(ptr);
+				_Uncount(header->scope, header->size);
+				char* block = static_cast<char*>(ptr) - header->offset;
+				if (header->sizeClass == heap_class) {
+					std::free(block);
+				}
+				else {
+					PoolHeap::Deallocate(block, header->sizeClass);
+				}
+			}
+
+			static VKAPI_ATTR void* VKAPI_CALL _Allocate(void* pUserData, size_t size, size_t alignment, VkSystemAllocationScope scope) {
+				if (!size) {
+					return nullptr;
+				}
+				return static_cast<HostAllocator*>(pUserData)->_AllocateAligned(size, alignment, scope);
+			}
+
+			// vulkan requires the same alignment as the original allocation, so the new allocation can simply be copied into
+			static VKAPI_ATTR void* VKAPI_CALL _Reallocate(void* pUserData, void* pOriginal, size_t size, size_t alignment, VkSystemAllocationScope scope) {
+				HostAllocator& allocator = *static_cast<HostAllocator*>(pUserData);
+				if (!pOriginal) {
+					return size ? allocator._AllocateAligned(size, alignment, scope) : nullptr;
+				}
+				if (!size) {
+					allocator._FreeAligned(pOriginal);
+					return nullptr;
+				}
+				size_t oldSize = _HeaderOf(pOriginal)->size;
+				void* result = allocator._AllocateAligned(size, alignment, scope);
+				if (!result) {
+					// the original stays valid on failure
+					return nullptr;
+				}
+				std::memcpy(result, pOriginal, oldSize < size ? oldSize : size);
+				allocator._FreeAligned(pOriginal);
+				return result;
+			}
+
+			static VKAPI_ATTR void VKAPI_CALL _Free(void* pUserData, void* pMemory) {
+				if (pMemory) {
+					static_cast<HostAllocator*>(pUserData)->_FreeAligned(pMemory);
+				}
+			}
+
+			static VKAPI_ATTR void VKAPI_CALL _InternalAllocation(void* pUserData, size_t size, VkInternalAllocationType, VkSystemAllocationScope scope) {
+				HostAllocator& allocator = *static_cast<HostAllocator*>(pUserData);
+				allocator._scopes[scope < scope_count ? scope : 0].internalBytes.fetch_add(size, std::memory_order_relaxed);
+			}
+
+			static VKAPI_ATTR void VKAPI_CALL _InternalFree(void* pUserData, size_t size, VkInternalAllocationType, VkSystemAllocationScope scope) {
+				HostAllocator& allocator = *static_cast<HostAllocator*>(pUserData);
+				allocator._scopes[scope < scope_count ? scope : 0].internalBytes.fetch_sub(size, std::memory_order_relaxed);
+			}
+
+			VkAllocationCallbacks _callbacks;
+			Scope _scopes[scope_count];
+		};
+	}
+}
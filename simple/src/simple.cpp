@@ -2,7 +2,9 @@
 #include "GLFW/glfw3.h"
 #include "simple_array.hpp"
 #include "simple_dynamic_array.hpp"
+#include "simple_small_dynamic_array.hpp"
 #include "simple_logging.hpp"
+#include "simple_static_map.hpp"
 #include "simple_string.hpp"
 #include "simple_vulkan.hpp"
 #include "simple_tuple.hpp"
@@ -43,14 +45,18 @@ namespace simple {
 	constexpr size_t layers_to_enable_count = 0;
 #endif
 
-	const String<> layersToEnable[] {
+	constexpr const char* layersToEnable[] {
 		"VK_LAYER_KHRONOS_validation",
 	};
 
-	const SimpleArray(const char*, 1) requiredDeviceExtensions {
+	constexpr StaticSet<std::string_view, std::size(layersToEnable)> layersToEnableSet(layersToEnable);
+
+	constexpr const char* requiredDeviceExtensions[] {
 		VK_KHR_SWAPCHAIN_EXTENSION_NAME,
 	};
 
+	constexpr StaticSet<std::string_view, std::size(requiredDeviceExtensions)> requiredDeviceExtensionsSet(requiredDeviceExtensions);
+
 	void Backend::_CreateSwapchain() {
 
 		vkGetPhysicalDeviceSurfaceCapabilitiesKHR(_vkPhysicalDevice, _vkSurfaceKHR, &_vulkanPhysicalDeviceInfo.vkSurfaceCapabilitiesKHR);
@@ -200,26 +206,26 @@ namespace simple {
 	Backend::Backend(Simple& engine) : _engine(engine) {
 
 		_mainThread._ID = std::this_thread::get_id();
+		FrameArena::Bind(&_frameArena);
 
 		uint32_t glfwRequiredExtensionsCount{};
 		const char** glfwRequiredExtensions = glfwGetRequiredInstanceExtensions(&glfwRequiredExtensionsCount);
-		DynamicArray<const char*> requiredInstanceExtensions(glfwRequiredExtensions, glfwRequiredExtensions + glfwRequiredExtensionsCount);
+		SmallDynamicArray<const char*, 8> requiredInstanceExtensions(glfwRequiredExtensions, glfwRequiredExtensions + glfwRequiredExtensionsCount);
 #ifdef _DEBUG
 		requiredInstanceExtensions.PushBack(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
 #endif
 
 		uint32_t vkLayerPropertyCount;
 		vkEnumerateInstanceLayerProperties(&vkLayerPropertyCount, nullptr);
-		DynamicArray<VkLayerProperties> vkLayerProperties(vkLayerPropertyCount);
+		SmallDynamicArray<VkLayerProperties, 16> vkLayerProperties{};
+		vkLayerProperties.ResizeUninitialized(vkLayerPropertyCount);
 		vkEnumerateInstanceLayerProperties(&vkLayerPropertyCount, vkLayerProperties.Data());
-		DynamicArray<const char*> enabledVkLayers{};
+		SmallDynamicArray<const char*, 4> enabledVkLayers{};
 		enabledVkLayers.Reserve(layers_to_enable_count);
 		for (VkLayerProperties& layerProperties : vkLayerProperties) {
-			auto iter = Find(layerProperties.layerName, &layersToEnable[0], &layersToEnable[layers_to_enable_count]);
-			if (iter != &layersToEnable[layers_to_enable_count]) {
+			if (layers_to_enable_count && layersToEnableSet.Contains(layerProperties.layerName)) {
 				enabledVkLayers.PushBack(layerProperties.layerName);
 			}
-
 		}
 		if (enabledVkLayers.Size() != layers_to_enable_count) {
 			logWarning(this, "some vulkan layer(s) requested are not supported (warning from simple::Backend constructor)!");
@@ -253,18 +259,18 @@ namespace simple {
 
 		uint32_t vkPhysicalDeviceCount;
 		vkEnumeratePhysicalDevices(_vkInstance, &vkPhysicalDeviceCount, nullptr);
-		simple::DynamicArray<VkPhysicalDevice> vkPhysicalDevices(vkPhysicalDeviceCount);
+		simple::SmallDynamicArray<VkPhysicalDevice, 4> vkPhysicalDevices{};
+		vkPhysicalDevices.ResizeUninitialized(vkPhysicalDeviceCount);
 		vkEnumeratePhysicalDevices(_vkInstance, &vkPhysicalDeviceCount, vkPhysicalDevices.Data());
 
 		Tuple<vulkan::PhysicalDeviceInfo, int> bestPhysicalDevice{};
 		for (VkPhysicalDevice device : vkPhysicalDevices) {
 			vulkan::PhysicalDeviceInfo deviceInfo(device, _vkSurfaceKHR);
-			bool allRequiredExtensionsFound = true;
+			size_t requiredExtensionsFound = 0;
 			for (const VkExtensionProperties& properties : deviceInfo.vkExtensionProperties) {
-				if (!Find(properties.extensionName, requiredDeviceExtensions.begin(), requiredDeviceExtensions.end())) {
-					allRequiredExtensionsFound = false;
-				}
+				requiredExtensionsFound += requiredDeviceExtensionsSet.Contains(properties.extensionName);
 			}
+			bool allRequiredExtensionsFound = requiredExtensionsFound == requiredDeviceExtensionsSet.Size();
 			int score = 10;
 			if (!deviceInfo.vkPhysicalDeviceFeatures.samplerAnisotropy ||
 				!deviceInfo.graphicsQueueFound || !deviceInfo.transferQueueFound || !deviceInfo.presentQueueFound ||
@@ -318,8 +324,8 @@ namespace simple {
 			.pNext = &vkPhysicalDeviceVulkan13Features,
 			.queueCreateInfoCount = vkDeviceQueueCreateInfos.Size(),
 			.pQueueCreateInfos = vkDeviceQueueCreateInfos.Data(),
-			.enabledExtensionCount = requiredDeviceExtensions.Size(),
-			.ppEnabledExtensionNames = requiredDeviceExtensions.Data(),
+			.enabledExtensionCount = static_cast<uint32_t>(std::size(requiredDeviceExtensions)),
+			.ppEnabledExtensionNames = requiredDeviceExtensions,
 			.pEnabledFeatures = &vkPhysicalDeviceFeatures,
 		};
 
@@ -0,0 +1,81 @@
+#include "simple_append_buffer.hpp"
+#include "simple_dynamic_array.hpp"
+#include "benchmark.hpp"
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Push throughput of simple::AppendBuffer with 1 to 32 producers while one consumer drains, like worker threads queueing
+// command buffers for the render thread. The mutex protected DynamicArray it replaced is measured the same way.
+
+constexpr uint32_t push_count = 1 << 21;
+
+struct MutexBuffer {
+
+	std::mutex mutex{};
+	simple::DynamicArray<uint64_t> values{};
+
+	inline void Push(uint64_t value) {
+		std::lock_guard lock(mutex);
+		values.PushBack(value);
+	}
+
+	inline void Drain(simple::DynamicArray<uint64_t>& out) {
+		simple::DynamicArray<uint64_t> taken{};
+		{
+			std::lock_guard lock(mutex);
+			taken = std::move(values);
+		}
+		out.AppendRange(taken.begin(), taken.end());
+	}
+};
+
+// total pushes are the same for every producer count, so the time per push shows how well it scales
+template<typename Buffer>
+static double Run(uint32_t producerCount) {
+	Buffer buffer{};
+	std::atomic<uint32_t> ready = 0;
+	std::atomic<bool> start = false;
+	std::atomic<uint32_t> running = producerCount;
+	std::vector<std::thread> producers{};
+	uint32_t perProducer = push_count / producerCount;
+	for (uint32_t producer = 0; producer < producerCount; producer++) {
+		producers.emplace_back([&, producer]() {
+			ready.fetch_add(1);
+			while (!start.load(std::memory_order_acquire)) {}
+			for (uint32_t i = 0; i < perProducer; i++) {
+				buffer.Push((uint64_t)producer << 32 | i);
+			}
+			running.fetch_sub(1, std::memory_order_release);
+		});
+	}
+	while (ready.load() != producerCount) {}
+	simple::DynamicArray<uint64_t> drained{};
+	drained.Reserve(push_count);
+	test::Clock::time_point begin = test::Clock::now();
+	start.store(true, std::memory_order_release);
+	// drains about once per frame like the render thread, so the numbers are dominated by the producers contending
+	while (running.load(std::memory_order_acquire)) {
+		buffer.Drain(drained);
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	buffer.Drain(drained);
+	double elapsed = test::ElapsedNanoseconds(begin, test::Clock::now());
+	for (std::thread& thread : producers) {
+		thread.join();
+	}
+	test::Consume(drained.Size());
+	return elapsed;
+}
+
+int main() {
+	char name[64];
+	for (uint32_t producers = 1; producers <= 32; producers *= 2) {
+		std::snprintf(name, sizeof(name), "AppendBuffer, %u producers", producers);
+		test::Report(name, push_count / producers * producers, Run<simple::AppendBuffer<uint64_t>>(producers));
+		std::snprintf(name, sizeof(name), "mutex + DynamicArray, %u producers", producers);
+		test::Report(name, push_count / producers * producers, Run<MutexBuffer>(producers));
+	}
+	return 0;
+}
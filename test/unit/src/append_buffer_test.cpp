@@ -0,0 +1,69 @@
+#include "simple_append_buffer.hpp"
+#include "simple_dynamic_array.hpp"
+#include "test.hpp"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// Producers push values tagged with their index and a sequence number while the consumer keeps draining, the segments
+// are small so they roll over and get recycled constantly. Every value has to come out exactly once and each producer's
+// values in the order they were pushed.
+
+template<uint32_t T_segment_size>
+static void Stress(uint32_t producerCount, uint32_t pushCount) {
+	simple::AppendBuffer<uint64_t, T_segment_size> buffer{};
+	std::atomic<uint32_t> running = producerCount;
+	std::atomic<bool> start = false;
+	std::vector<std::thread> producers{};
+	for (uint32_t producer = 0; producer < producerCount; producer++) {
+		producers.emplace_back([&buffer, &running, &start, producer, pushCount]() {
+			while (!start.load(std::memory_order_acquire)) {
+				std::this_thread::yield();
+			}
+			for (uint32_t i = 0; i < pushCount; i++) {
+				buffer.Push((uint64_t)producer << 32 | i);
+			}
+			running.fetch_sub(1, std::memory_order_release);
+		});
+	}
+	std::vector<uint32_t> next(producerCount, 0);
+	simple::DynamicArray<uint64_t> drained{};
+	auto check = [&]() {
+		for (uint64_t value : drained) {
+			uint32_t producer = (uint32_t)(value >> 32);
+			uint32_t sequence = (uint32_t)value;
+			SIMPLE_CHECK(producer < producerCount);
+			// also catches duplicates, a repeated value is out of order
+			SIMPLE_CHECK(sequence == next[producer]);
+			next[producer]++;
+		}
+		drained.Clear();
+	};
+	start.store(true, std::memory_order_release);
+	// how many drains overlap the pushes is up to the scheduler, on a single core it can be none
+	while (running.load(std::memory_order_acquire)) {
+		buffer.Drain(drained);
+		check();
+	}
+	for (std::thread& thread : producers) {
+		thread.join();
+	}
+	buffer.Drain(drained);
+	check();
+	for (uint32_t producer = 0; producer < producerCount; producer++) {
+		SIMPLE_CHECK(next[producer] == pushCount);
+	}
+	// nothing is left behind
+	buffer.Drain(drained);
+	SIMPLE_CHECK(drained.Size() == 0);
+}
+
+int main() {
+	Stress<1>(4, 20000);
+	Stress<4>(8, 50000);
+	Stress<64>(8, 200000);
+	Stress<64>(1, 100000);
+	uint32_t hardware = std::thread::hardware_concurrency();
+	Stress<16>(hardware > 2 ? hardware * 2 : 4, 20000);
+	return 0;
+}
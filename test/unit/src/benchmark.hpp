@@ -0,0 +1,76 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+namespace test {
+
+	using Clock = std::chrono::steady_clock;
+
+	inline double ElapsedNanoseconds(Clock::time_point begin, Clock::time_point end) noexcept {
+		return std::chrono::duration<double, std::nano>(end - begin).count();
+	}
+
+	// runs func repeat times and returns the fastest run in nanoseconds, the fastest run is the one least disturbed by the
+	// rest of the system
+	template<typename Func>
+	inline double Measure(uint32_t repeat, Func&& func) {
+		double best = 0.0;
+		for (uint32_t i = 0; i < repeat; i++) {
+			Clock::time_point begin = Clock::now();
+			func();
+			double elapsed = ElapsedNanoseconds(begin, Clock::now());
+			best = i && best < elapsed ? best : elapsed;
+		}
+		return best;
+	}
+
+	// keeps the compiler from optimizing away work whose result is otherwise unused
+	inline void Consume(uint64_t value) noexcept {
+		static volatile uint64_t sink;
+		sink = value;
+	}
+
+	// hides value from the compiler, so work that depends on it can't be hoisted out of the measured loop
+	template<typename T>
+	inline T Opaque(T value) noexcept {
+		volatile T copy = value;
+		return copy;
+	}
+
+	inline void Report(const char* name, uint64_t operations, double nanoseconds) {
+		std::printf("%-48s %12.2f ns/op %14.0f op/s\n", name, nanoseconds / operations, operations / nanoseconds * 1e9);
+	}
+
+	// sorted latencies in nanoseconds, for benchmarks that care about the tail rather than the mean
+	struct Latencies {
+
+		std::vector<double> samples;
+
+		inline double Percentile(double percentile) {
+			if (samples.empty()) {
+				return 0.0;
+			}
+			std::sort(samples.begin(), samples.end());
+			size_t index = static_cast<size_t>(percentile / 100.0 * (samples.size() - 1));
+			return samples[index];
+		}
+
+		inline double Mean() const {
+			double sum = 0.0;
+			for (double sample : samples) {
+				sum += sample;
+			}
+			return samples.empty() ? 0.0 : sum / samples.size();
+		}
+
+		inline void Report(const char* name) {
+			double mean = Mean();
+			std::printf("%-48s mean %9.1f ns  p50 %9.1f ns  p99 %9.1f ns  p99.9 %9.1f ns  max %11.1f ns\n",
+				name, mean, Percentile(50.0), Percentile(99.0), Percentile(99.9), Percentile(100.0));
+		}
+	};
+}
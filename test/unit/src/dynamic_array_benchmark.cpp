@@ -0,0 +1,93 @@
+#include "simple_dynamic_array.hpp"
+#include "benchmark.hpp"
+#include <cstring>
+
+// Push, insert and erase throughput of simple::DynamicArray for a Mat4 sized payload, once trivially relocatable (bulk
+// memmove/realloc) and once with a user provided move constructor, which forces the element-wise path.
+
+struct Trivial {
+	float m[16];
+};
+
+struct Elementwise {
+
+	float m[16];
+
+	inline Elementwise() noexcept : m() {}
+
+	inline Elementwise(const Trivial& value) noexcept {
+		std::memcpy(m, value.m, sizeof(m));
+	}
+
+	inline Elementwise(const Elementwise& other) noexcept {
+		std::memcpy(m, other.m, sizeof(m));
+	}
+
+	inline Elementwise(Elementwise&& other) noexcept {
+		std::memcpy(m, other.m, sizeof(m));
+	}
+
+	inline Elementwise& operator=(const Elementwise& other) noexcept {
+		std::memcpy(m, other.m, sizeof(m));
+		return *this;
+	}
+
+	inline Elementwise& operator=(Elementwise&& other) noexcept {
+		std::memcpy(m, other.m, sizeof(m));
+		return *this;
+	}
+};
+
+static_assert(simple::trivially_relocatable<Trivial> && !simple::trivially_relocatable<Elementwise>);
+
+template<typename T>
+static void Run(const char* typeName) {
+	constexpr uint32_t repeat = 5;
+	constexpr uint32_t push_count = 1000000;
+	constexpr uint32_t middle_count = 20000;
+	constexpr uint32_t middle_operations = 2000;
+	char name[64];
+	Trivial value{};
+	value.m[0] = 1.0f;
+
+	double push = test::Measure(repeat, [&]() {
+		simple::DynamicArray<T> array{};
+		for (uint32_t i = 0; i < push_count; i++) {
+			array.PushBack(value);
+		}
+		test::Consume(array.Size());
+	});
+	std::snprintf(name, sizeof(name), "PushBack (%s)", typeName);
+	test::Report(name, push_count, push);
+
+	simple::DynamicArray<T> base{};
+	for (uint32_t i = 0; i < middle_count; i++) {
+		base.PushBack(value);
+	}
+
+	double insert = test::Measure(repeat, [&]() {
+		simple::DynamicArray<T> array(base);
+		for (uint32_t i = 0; i < middle_operations; i++) {
+			array.Insert(array.begin() + array.Size() / 2, value);
+		}
+		test::Consume(array.Size());
+	});
+	std::snprintf(name, sizeof(name), "Insert middle of %u (%s)", middle_count, typeName);
+	test::Report(name, middle_operations, insert);
+
+	double erase = test::Measure(repeat, [&]() {
+		simple::DynamicArray<T> array(base);
+		for (uint32_t i = 0; i < middle_operations; i++) {
+			array.Erase(array.begin() + array.Size() / 2);
+		}
+		test::Consume(array.Size());
+	});
+	std::snprintf(name, sizeof(name), "Erase middle of %u (%s)", middle_count, typeName);
+	test::Report(name, middle_operations, erase);
+}
+
+int main() {
+	Run<Trivial>("bulk");
+	Run<Elementwise>("element-wise");
+	return 0;
+}
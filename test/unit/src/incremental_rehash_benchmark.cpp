@@ -0,0 +1,64 @@
+#include "simple_map.hpp"
+#include "simple_set.hpp"
+#include "benchmark.hpp"
+#include "test.hpp"
+#include <cstdlib>
+#include <vector>
+
+// Latency of every single insert while simple::Map (both layouts) and simple::Set grow from empty to 2M random keys, for
+// a full rehash (budget 0) against incremental rehashing with a few budgets. The mean barely moves, the tail is what the
+// budget is for: a full rehash stalls one insert for the whole table, incremental rehashing spreads it over the following
+// operations. The number of keys can be changed with the first argument.
+
+template<typename Container>
+struct Adapter {
+
+	Container container{};
+
+	inline void Insert(uint64_t key) {
+		container.Insert({ key, key });
+	}
+};
+
+template<typename T, typename Hasher, typename Allocator>
+struct Adapter<simple::Set<T, Hasher, Allocator>> {
+
+	simple::Set<T, Hasher, Allocator> container{};
+
+	inline void Insert(uint64_t key) {
+		container.Insert(key);
+	}
+};
+
+template<typename Container>
+static void Run(const char* containerName, const std::vector<uint64_t>& keys) {
+	char name[96];
+	for (uint32_t budget : { 0u, 4u, 16u, 64u }) {
+		Adapter<Container>* adapter = new Adapter<Container>();
+		adapter->container.SetRehashBudget(budget);
+		test::Latencies latencies{};
+		latencies.samples.reserve(keys.size());
+		for (uint64_t key : keys) {
+			test::Clock::time_point begin = test::Clock::now();
+			adapter->Insert(key);
+			latencies.samples.push_back(test::ElapsedNanoseconds(begin, test::Clock::now()));
+		}
+		test::Consume(adapter->container.Size());
+		std::snprintf(name, sizeof(name), "%s insert, budget %u", containerName, budget);
+		latencies.Report(name);
+		delete adapter;
+	}
+}
+
+int main(int argc, char** argv) {
+	uint32_t count = argc > 1 ? (uint32_t)std::strtoul(argv[1], nullptr, 10) : 1u << 21;
+	test::Random random(7);
+	std::vector<uint64_t> keys(count);
+	for (uint64_t& key : keys) {
+		key = random.Next();
+	}
+	Run<simple::Map<uint64_t, uint64_t, std::hash<uint64_t>>>("Map", keys);
+	Run<simple::DenseMap<uint64_t, uint64_t, std::hash<uint64_t>>>("DenseMap", keys);
+	Run<simple::Set<uint64_t, std::hash<uint64_t>>>("Set", keys);
+	return 0;
+}
@@ -0,0 +1,265 @@
+#include "simple_map.hpp"
+#include "simple_set.hpp"
+#include "test.hpp"
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+// Lookups, inserts and erases on simple::Map (both layouts) and simple::Set while an incremental rehash is in progress,
+// checked against the std containers. The containers grow from empty with a small rehash budget, so most operations land
+// in the middle of a migration and see entries split between the old and the new table. Copies, moves, swaps, Clear,
+// Reserve and turning the budget off are also done mid-rehash.
+
+struct Colliding {
+	inline uint64_t operator()(uint64_t key) const noexcept {
+		return key % 61;
+	}
+};
+
+template<typename Val>
+static Val MakeValue(uint64_t value) {
+	if constexpr (std::is_same_v<Val, std::string>) {
+		return "value number " + std::to_string(value) + " of the rehash test";
+	}
+	else {
+		return static_cast<Val>(value);
+	}
+}
+
+template<typename MapType, typename Val>
+static void CheckMap(const MapType& map, const std::unordered_map<uint64_t, Val>& reference) {
+	SIMPLE_CHECK(map.Size() == reference.size());
+	size_t count = 0;
+	for (const auto& pair : map) {
+		auto iter = reference.find(pair.first);
+		SIMPLE_CHECK(iter != reference.end() && iter->second == pair.second);
+		count++;
+	}
+	SIMPLE_CHECK(count == reference.size());
+	for (const auto& [key, value] : reference) {
+		auto pair = map.Find(key);
+		SIMPLE_CHECK(pair && pair->second == value);
+	}
+}
+
+template<typename SetType>
+static void CheckSet(const SetType& set, const std::unordered_set<uint64_t>& reference) {
+	SIMPLE_CHECK(set.Size() == reference.size());
+	size_t count = 0;
+	for (uint64_t value : set) {
+		SIMPLE_CHECK(reference.count(value));
+		count++;
+	}
+	SIMPLE_CHECK(count == reference.size());
+	for (uint64_t value : reference) {
+		const uint64_t* found = set.Find(value);
+		SIMPLE_CHECK(found && *found == value);
+	}
+}
+
+// Grows maps from empty to about keyRange / 2 entries with mostly inserts, rounds times. Returns how many operations ran
+// while a rehash was in progress.
+template<typename MapType, typename Val>
+static uint64_t MapMidRehash(uint32_t budget, uint64_t keyRange, uint32_t rounds, uint64_t seed) {
+	test::Random random(seed);
+	uint64_t midRehash = 0;
+	for (uint32_t round = 0; round < rounds; round++) {
+		MapType map{};
+		map.SetRehashBudget(budget);
+		std::unordered_map<uint64_t, Val> reference{};
+		bool wasRehashing = false;
+		while (reference.size() < keyRange / 2) {
+			bool rehashing = map.IsRehashing();
+			midRehash += rehashing;
+			// the tables change hands when a migration starts and ends
+			if (rehashing != wasRehashing) {
+				CheckMap(map, reference);
+				wasRehashing = rehashing;
+			}
+			uint64_t key = random.Below(keyRange);
+			uint64_t roll = random.Below(1000);
+			if (roll < 500) {
+				Val value = MakeValue<Val>(random.Next());
+				auto [inserted, pair] = map.Insert({ key, value });
+				auto [iter, referenceInserted] = reference.insert({ key, value });
+				SIMPLE_CHECK(inserted == referenceInserted);
+				SIMPLE_CHECK(pair && pair->first == key && pair->second == iter->second);
+			}
+			else if (roll < 650) {
+				SIMPLE_CHECK(map.Erase(key) == (reference.erase(key) == 1));
+			}
+			else if (roll < 850) {
+				auto pair = map.Find(key);
+				auto iter = reference.find(key);
+				SIMPLE_CHECK((pair != nullptr) == (iter != reference.end()));
+				SIMPLE_CHECK(!pair || pair->second == iter->second);
+				SIMPLE_CHECK(map.Contains(key) == (iter != reference.end()));
+			}
+			else if (roll < 950) {
+				Val value = MakeValue<Val>(random.Next());
+				*map[key] = value;
+				reference[key] = value;
+			}
+			else if (roll < 990) {
+				auto [inserted, pair] = map.Emplace(key);
+				auto [iter, referenceInserted] = reference.try_emplace(key);
+				SIMPLE_CHECK(inserted == referenceInserted && pair->second == iter->second);
+			}
+			else if (roll < 995 && rehashing && reference.size() < 2048) {
+				// copies rebuild from both tables, moves and swaps take the migration along
+				MapType copy(map);
+				CheckMap(copy, reference);
+				MapType other{};
+				other.SetRehashBudget(budget);
+				other.Swap(map);
+				CheckMap(other, reference);
+				SIMPLE_CHECK(map.Size() == 0 && map.begin() == map.end());
+				map = std::move(other);
+				CheckMap(map, reference);
+			}
+			else if (roll < 997 && rehashing) {
+				// Reserve and turning the budget off both finish the migration first
+				if (random.Below(2)) {
+					map.Reserve(map.Capacity() * 2);
+				}
+				else {
+					map.SetRehashBudget(0);
+					SIMPLE_CHECK(!map.IsRehashing());
+					map.SetRehashBudget(budget);
+				}
+				CheckMap(map, reference);
+			}
+			else if (rehashing && random.Below(4) == 0) {
+				if (random.Below(2)) {
+					map.Clear();
+				}
+				else {
+					// erasing every entry of the old table ends the migration early
+					std::unordered_map<uint64_t, Val> remaining = reference;
+					for (const auto& [erasedKey, value] : remaining) {
+						SIMPLE_CHECK(map.Erase(erasedKey));
+					}
+				}
+				reference.clear();
+				SIMPLE_CHECK(!map.IsRehashing());
+				CheckMap(map, reference);
+			}
+			if (rehashing && random.Below(64) == 0) {
+				CheckMap(map, reference);
+			}
+		}
+		CheckMap(map, reference);
+		while (!map.Step(budget)) {}
+		CheckMap(map, reference);
+	}
+	return midRehash;
+}
+
+template<typename SetType>
+static uint64_t SetMidRehash(uint32_t budget, uint64_t keyRange, uint32_t rounds, uint64_t seed) {
+	test::Random random(seed);
+	uint64_t midRehash = 0;
+	for (uint32_t round = 0; round < rounds; round++) {
+		SetType set{};
+		set.SetRehashBudget(budget);
+		std::unordered_set<uint64_t> reference{};
+		bool wasRehashing = false;
+		while (reference.size() < keyRange / 2) {
+			bool rehashing = set.IsRehashing();
+			midRehash += rehashing;
+			if (rehashing != wasRehashing) {
+				CheckSet(set, reference);
+				wasRehashing = rehashing;
+			}
+			uint64_t value = random.Below(keyRange);
+			uint64_t roll = random.Below(1000);
+			if (roll < 500) {
+				auto [inserted, element] = set.Insert(value);
+				SIMPLE_CHECK(inserted == reference.insert(value).second);
+				SIMPLE_CHECK(element && *element == value);
+			}
+			else if (roll < 650) {
+				SIMPLE_CHECK(set.Erase(value) == (reference.erase(value) == 1));
+			}
+			else if (roll < 900) {
+				const uint64_t* found = set.Find(value);
+				bool contained = reference.count(value);
+				SIMPLE_CHECK((found != nullptr) == contained && (!found || *found == value));
+				SIMPLE_CHECK(set.Contains(value) == contained);
+			}
+			else if (roll < 990) {
+				auto [inserted, element] = set.Emplace(value);
+				SIMPLE_CHECK(inserted == reference.insert(value).second);
+				SIMPLE_CHECK(*element == value);
+			}
+			else if (roll < 995 && rehashing && reference.size() < 2048) {
+				SetType copy(set);
+				CheckSet(copy, reference);
+				SetType other{};
+				other.SetRehashBudget(budget);
+				other.Swap(set);
+				CheckSet(other, reference);
+				SIMPLE_CHECK(set.Size() == 0 && set.begin() == set.end());
+				set = std::move(other);
+				CheckSet(set, reference);
+			}
+			else if (roll < 997 && rehashing) {
+				if (random.Below(2)) {
+					set.Reserve(set.Capacity() * 2);
+				}
+				else {
+					set.SetRehashBudget(0);
+					SIMPLE_CHECK(!set.IsRehashing());
+					set.SetRehashBudget(budget);
+				}
+				CheckSet(set, reference);
+			}
+			else if (rehashing && random.Below(4) == 0) {
+				if (random.Below(2)) {
+					set.Clear();
+				}
+				else {
+					std::unordered_set<uint64_t> remaining = reference;
+					for (uint64_t erased : remaining) {
+						SIMPLE_CHECK(set.Erase(erased));
+					}
+				}
+				reference.clear();
+				SIMPLE_CHECK(!set.IsRehashing());
+				CheckSet(set, reference);
+			}
+			if (rehashing && random.Below(64) == 0) {
+				CheckSet(set, reference);
+			}
+		}
+		CheckSet(set, reference);
+		while (!set.Step(budget)) {}
+		CheckSet(set, reference);
+	}
+	return midRehash;
+}
+
+template<simple::MapLayout T_layout>
+static void RunLayout(uint64_t seed) {
+	for (uint32_t budget : { 1u, 3u, 16u }) {
+		uint64_t midRehash = MapMidRehash<simple::Map<uint64_t, uint64_t, std::hash<uint64_t>, T_layout>, uint64_t>(budget, 40000, 8, seed);
+		midRehash += MapMidRehash<simple::Map<uint64_t, std::string, std::hash<uint64_t>, T_layout>, std::string>(budget, 8000, 8, seed + 1);
+		midRehash += MapMidRehash<simple::Map<uint64_t, uint64_t, Colliding, T_layout>, uint64_t>(budget, 1200, 16, seed + 2);
+		// otherwise the test didn't test anything
+		SIMPLE_CHECK(midRehash > 2000);
+		seed += 3;
+	}
+}
+
+int main() {
+	RunLayout<simple::MapLayout::Flat>(1);
+	RunLayout<simple::MapLayout::Dense>(101);
+	uint64_t seed = 201;
+	for (uint32_t budget : { 1u, 3u, 16u }) {
+		uint64_t midRehash = SetMidRehash<simple::Set<uint64_t, std::hash<uint64_t>>>(budget, 40000, 8, seed);
+		midRehash += SetMidRehash<simple::Set<uint64_t, Colliding>>(budget, 1200, 16, seed + 1);
+		SIMPLE_CHECK(midRehash > 2000);
+		seed += 2;
+	}
+	return 0;
+}
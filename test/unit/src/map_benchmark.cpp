@@ -0,0 +1,116 @@
+#include "simple_map.hpp"
+#include "benchmark.hpp"
+#include "test.hpp"
+#include <cstdlib>
+#include <unordered_map>
+#include <vector>
+
+// simple::Map (both layouts) against std::unordered_map from 1K to 10M random 64 bit keys: insert, successful and failed
+// lookups, iteration and erase. The largest size can be lowered with the first argument on machines with little memory.
+
+template<typename MapType>
+struct Adapter {
+
+	MapType map{};
+
+	inline void Insert(uint64_t key, uint64_t value) {
+		map.Insert({ key, value });
+	}
+
+	inline bool Contains(uint64_t key) const {
+		return map.Find(key) != nullptr;
+	}
+
+	inline void Erase(uint64_t key) {
+		map.Erase(key);
+	}
+};
+
+template<>
+struct Adapter<std::unordered_map<uint64_t, uint64_t>> {
+
+	std::unordered_map<uint64_t, uint64_t> map{};
+
+	inline void Insert(uint64_t key, uint64_t value) {
+		map.insert({ key, value });
+	}
+
+	inline bool Contains(uint64_t key) const {
+		return map.find(key) != map.end();
+	}
+
+	inline void Erase(uint64_t key) {
+		map.erase(key);
+	}
+};
+
+template<typename MapType>
+static void Run(const char* mapName, const std::vector<uint64_t>& keys, const std::vector<uint64_t>& missing) {
+	uint32_t count = (uint32_t)keys.size();
+	char name[96];
+	Adapter<MapType>* adapter = new Adapter<MapType>();
+
+	test::Clock::time_point begin = test::Clock::now();
+	for (uint64_t key : keys) {
+		adapter->Insert(key, key);
+	}
+	double elapsed = test::ElapsedNanoseconds(begin, test::Clock::now());
+	std::snprintf(name, sizeof(name), "%s %u insert", mapName, count);
+	test::Report(name, count, elapsed);
+
+	uint64_t found = 0;
+	elapsed = test::Measure(3, [&]() {
+		for (uint64_t key : keys) {
+			found += adapter->Contains(key);
+		}
+	});
+	std::snprintf(name, sizeof(name), "%s %u find hit", mapName, count);
+	test::Report(name, count, elapsed);
+
+	elapsed = test::Measure(3, [&]() {
+		for (uint64_t key : missing) {
+			found += adapter->Contains(key);
+		}
+	});
+	std::snprintf(name, sizeof(name), "%s %u find miss", mapName, count);
+	test::Report(name, count, elapsed);
+
+	uint64_t sum = 0;
+	elapsed = test::Measure(3, [&]() {
+		for (const auto& pair : adapter->map) {
+			sum += pair.second;
+		}
+	});
+	std::snprintf(name, sizeof(name), "%s %u iterate", mapName, count);
+	test::Report(name, count, elapsed);
+
+	begin = test::Clock::now();
+	for (uint64_t key : keys) {
+		adapter->Erase(key);
+	}
+	elapsed = test::ElapsedNanoseconds(begin, test::Clock::now());
+	std::snprintf(name, sizeof(name), "%s %u erase", mapName, count);
+	test::Report(name, count, elapsed);
+
+	test::Consume(found + sum);
+	delete adapter;
+}
+
+int main(int argc, char** argv) {
+	uint32_t maxCount = argc > 1 ? (uint32_t)std::strtoul(argv[1], nullptr, 10) : 10000000;
+	test::Random random{};
+	for (uint32_t count = 1000; count <= maxCount; count *= 10) {
+		std::vector<uint64_t> keys(count);
+		std::vector<uint64_t> missing(count);
+		// odd keys are inserted, even ones are looked up and missing
+		for (uint32_t i = 0; i < count; i++) {
+			keys[i] = random.Next() | 1;
+			missing[i] = random.Next() & ~1ull;
+		}
+		Run<simple::Map<uint64_t, uint64_t, std::hash<uint64_t>>>("simple::Map", keys, missing);
+		Run<simple::DenseMap<uint64_t, uint64_t, std::hash<uint64_t>>>("simple::DenseMap", keys, missing);
+		Run<std::unordered_map<uint64_t, uint64_t>>("std::unordered_map", keys, missing);
+		std::printf("\n");
+	}
+	return 0;
+}
@@ -0,0 +1,204 @@
+#include "simple_map.hpp"
+#include "test.hpp"
+#include <string>
+#include <unordered_map>
+
+// Random inserts, erases and lookups on simple::Map (both layouts) checked against std::unordered_map after every operation.
+// The colliding hasher only produces a few distinct hashes, so probe runs get long and wrap around the table, which is
+// where backward shift deletion and growth have to be right.
+
+struct Colliding {
+	inline uint64_t operator()(uint64_t key) const noexcept {
+		return key % 61;
+	}
+};
+
+struct Identity {
+	inline uint64_t operator()(uint64_t key) const noexcept {
+		return key;
+	}
+};
+
+template<typename Val>
+static Val MakeValue(uint64_t value) {
+	if constexpr (std::is_same_v<Val, std::string>) {
+		// long enough to live on the heap, so moving a pair really moves memory
+		return "value number " + std::to_string(value) + " of the map test";
+	}
+	else {
+		return static_cast<Val>(value);
+	}
+}
+
+template<typename MapType, typename Val>
+static void CheckEqual(const MapType& map, const std::unordered_map<uint64_t, Val>& reference) {
+	SIMPLE_CHECK(map.Size() == reference.size());
+	size_t count = 0;
+	for (const auto& pair : map) {
+		auto iter = reference.find(pair.first);
+		SIMPLE_CHECK(iter != reference.end());
+		SIMPLE_CHECK(iter->second == pair.second);
+		count++;
+	}
+	SIMPLE_CHECK(count == reference.size());
+	for (const auto& [key, value] : reference) {
+		auto pair = map.Find(key);
+		SIMPLE_CHECK(pair && pair->second == value);
+	}
+	// the table never gets fuller than 7/8
+	SIMPLE_CHECK(map.Size() <= map.Capacity() - map.Capacity() / 8);
+}
+
+template<typename MapType, typename Val>
+static void RandomOperations(uint64_t keyRange, uint32_t operationCount, uint64_t seed) {
+	MapType map{};
+	std::unordered_map<uint64_t, Val> reference{};
+	test::Random random(seed);
+	for (uint32_t i = 0; i < operationCount; i++) {
+		uint64_t key = random.Below(keyRange);
+		uint64_t roll = random.Below(100);
+		if (roll < 35) {
+			Val value = MakeValue<Val>(random.Next());
+			auto [inserted, pair] = map.Insert({ key, value });
+			auto [iter, referenceInserted] = reference.insert({ key, value });
+			SIMPLE_CHECK(inserted == referenceInserted);
+			SIMPLE_CHECK(pair && pair->first == key && pair->second == iter->second);
+		}
+		else if (roll < 60) {
+			SIMPLE_CHECK(map.Erase(key) == (reference.erase(key) == 1));
+		}
+		else if (roll < 75) {
+			auto pair = map.Find(key);
+			auto iter = reference.find(key);
+			SIMPLE_CHECK((pair != nullptr) == (iter != reference.end()));
+			SIMPLE_CHECK(!pair || pair->second == iter->second);
+			SIMPLE_CHECK(map.Contains(key) == (iter != reference.end()));
+		}
+		else if (roll < 90) {
+			Val value = MakeValue<Val>(random.Next());
+			*map[key] = value;
+			reference[key] = value;
+		}
+		else if (roll < 99) {
+			auto [inserted, pair] = map.Emplace(key);
+			auto [iter, referenceInserted] = reference.try_emplace(key);
+			SIMPLE_CHECK(inserted == referenceInserted);
+			SIMPLE_CHECK(pair->second == iter->second);
+		}
+		else if (random.Below(50) == 0) {
+			map.Clear();
+			reference.clear();
+		}
+		else if (reference.size() < 4096) {
+			// copies and moves keep the contents
+			MapType copy(map);
+			CheckEqual(copy, reference);
+			MapType moved(std::move(copy));
+			CheckEqual(moved, reference);
+			map = std::move(moved);
+		}
+		// full comparisons are linear, so large maps are compared less often
+		if (i % (reference.size() < 4096 ? 64 : 16384) == 0) {
+			CheckEqual(map, reference);
+		}
+	}
+	CheckEqual(map, reference);
+	// erasing everything leaves an empty table behind that still works
+	for (uint64_t key = 0; key < keyRange; key++) {
+		map.Erase(key);
+	}
+	SIMPLE_CHECK(map.Size() == 0 && map.begin() == map.end());
+	map.Insert({ 1, MakeValue<Val>(1) });
+	SIMPLE_CHECK(map.Size() == 1 && map.Find(1));
+}
+
+// inserting a lot of keys from empty grows the table many times and never drops an insert
+template<typename MapType>
+static void Growth(uint32_t count) {
+	MapType map{};
+	for (uint64_t key = 0; key < count; key++) {
+		SIMPLE_CHECK(map.Insert({ key * 7919, key }).first);
+	}
+	SIMPLE_CHECK(map.Size() == count);
+	for (uint64_t key = 0; key < count; key++) {
+		auto pair = map.Find(key * 7919);
+		SIMPLE_CHECK(pair && pair->second == key);
+		SIMPLE_CHECK(!map.Find(key * 7919 + 1));
+	}
+	MapType reserved{};
+	reserved.Reserve(count);
+	uint32_t capacity = reserved.Capacity();
+	for (uint64_t key = 0; key < count; key++) {
+		reserved.Insert({ key, key });
+	}
+	SIMPLE_CHECK(reserved.Capacity() == capacity);
+}
+
+// counts the bytes it hands out, copies and rebound copies share the count
+template<typename T>
+struct CountingAllocator {
+
+	size_t* liveBytes;
+
+	inline CountingAllocator(size_t* bytes) noexcept : liveBytes(bytes) {}
+
+	template<typename U>
+	inline CountingAllocator(const CountingAllocator<U>& other) noexcept : liveBytes(other.liveBytes) {}
+
+	inline T* allocate(size_t size) {
+		*liveBytes += size * sizeof(T);
+		return static_cast<T*>(std::malloc(size * sizeof(T)));
+	}
+
+	inline void deallocate(T* ptr, size_t size) noexcept {
+		*liveBytes -= size * sizeof(T);
+		std::free(ptr);
+	}
+
+	template<typename... Args>
+	inline void construct(T* ptr, Args&&... args) {
+		new(ptr) T(std::forward<Args>(args)...);
+	}
+
+	inline void destroy(T* ptr) noexcept {
+		ptr->~T();
+	}
+
+	friend bool operator==(const CountingAllocator& a, const CountingAllocator& b) {
+		return a.liveBytes == b.liveBytes;
+	}
+};
+
+// the control bytes (and the index table of the dense layout) come from the map's allocator too
+template<simple::MapLayout T_layout>
+static void AllocatorRouting() {
+	typedef simple::Pair<uint64_t, uint64_t> Entry;
+	size_t liveBytes = 0;
+	{
+		simple::Map<uint64_t, uint64_t, Identity, T_layout, CountingAllocator<Entry>> map{ CountingAllocator<Entry>(&liveBytes) };
+		for (uint64_t key = 0; key < 5000; key++) {
+			map.Insert({ key, key });
+		}
+		size_t tableBytes = T_layout == simple::MapLayout::Dense ? sizeof(uint32_t) + 1 : sizeof(Entry) + 1;
+		SIMPLE_CHECK(liveBytes >= map.Capacity() * tableBytes);
+	}
+	SIMPLE_CHECK(liveBytes == 0);
+}
+
+template<simple::MapLayout T_layout, typename Val>
+static void RunLayout(uint64_t seed) {
+	RandomOperations<simple::Map<uint64_t, Val, Identity, T_layout>, Val>(2000, 60000, seed);
+	RandomOperations<simple::Map<uint64_t, Val, Colliding, T_layout>, Val>(500, 30000, seed + 1);
+	RandomOperations<simple::Map<uint64_t, Val, std::hash<uint64_t>, T_layout>, Val>(50, 20000, seed + 2);
+	RandomOperations<simple::Map<uint64_t, Val, std::hash<uint64_t>, T_layout>, Val>(100000, 200000, seed + 3);
+	Growth<simple::Map<uint64_t, uint64_t, std::hash<uint64_t>, T_layout>>(300000);
+	AllocatorRouting<T_layout>();
+}
+
+int main() {
+	RunLayout<simple::MapLayout::Flat, uint64_t>(1);
+	RunLayout<simple::MapLayout::Flat, std::string>(11);
+	RunLayout<simple::MapLayout::Dense, uint64_t>(21);
+	RunLayout<simple::MapLayout::Dense, std::string>(31);
+	return 0;
+}
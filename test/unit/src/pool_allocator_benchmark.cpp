@@ -0,0 +1,161 @@
+#include "simple_allocator.hpp"
+#include "simple_pool_allocator.hpp"
+#include "benchmark.hpp"
+#include "test.hpp"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// Create/destroy churn of small objects with simple::PoolAllocator against simple::DynamicAllocator from 1 to 16 threads.
+// Every thread keeps a window of live objects of three sizes and keeps replacing random ones, like the components and
+// command records that come and go every frame. Objects are also handed to the next thread now and then and destroyed
+// there, so cells travel between the thread caches through the shared chains.
+
+constexpr uint32_t operation_count = 1 << 22;
+constexpr uint32_t window_size = 1024;
+constexpr uint32_t handoff_count = 64;
+
+template<size_t T_size>
+struct Payload {
+	uint64_t words[T_size / sizeof(uint64_t)];
+
+	inline explicit Payload(uint64_t value) noexcept {
+		for (uint64_t& word : words) {
+			word = value;
+		}
+	}
+};
+
+// a live object of any of the three sizes, remembers which one so it can be destroyed with the right allocator
+struct Object {
+	void* ptr;
+	uint32_t sizeClass;
+};
+
+template<template<typename> typename Allocator>
+struct Churn {
+
+	Allocator<Payload<32>> small{};
+	Allocator<Payload<128>> medium{};
+	Allocator<Payload<512>> large{};
+
+	template<typename T, typename Alloc>
+	static inline void* _Create(Alloc& allocator, uint64_t value) {
+		T* ptr = allocator.allocate(1);
+		allocator.construct(ptr, value);
+		return ptr;
+	}
+
+	template<typename T, typename Alloc>
+	static inline void _Destroy(Alloc& allocator, void* ptr) {
+		allocator.destroy(static_cast<T*>(ptr));
+		allocator.deallocate(static_cast<T*>(ptr), 1);
+	}
+
+	inline Object Create(uint32_t sizeClass, uint64_t value) {
+		switch (sizeClass) {
+		case 0:
+			return { _Create<Payload<32>>(small, value), 0 };
+		case 1:
+			return { _Create<Payload<128>>(medium, value), 1 };
+		default:
+			return { _Create<Payload<512>>(large, value), 2 };
+		}
+	}
+
+	inline void Destroy(Object object) {
+		switch (object.sizeClass) {
+		case 0:
+			_Destroy<Payload<32>>(small, object.ptr);
+			break;
+		case 1:
+			_Destroy<Payload<128>>(medium, object.ptr);
+			break;
+		default:
+			_Destroy<Payload<512>>(large, object.ptr);
+			break;
+		}
+	}
+};
+
+// objects handed from one thread to the next, only ever touched by the two threads under the flag
+struct alignas(simple::cache_line_size) Handoff {
+	std::atomic<bool> full{};
+	Object objects[handoff_count];
+};
+
+// total operations are the same for every thread count, so the time per operation shows how well it scales
+template<template<typename> typename Allocator>
+static double Run(uint32_t threadCount) {
+	std::vector<Handoff> handoffs(threadCount);
+	std::atomic<uint32_t> ready = 0;
+	std::atomic<bool> start = false;
+	std::vector<std::thread> threads{};
+	uint32_t perThread = operation_count / threadCount;
+	for (uint32_t index = 0; index < threadCount; index++) {
+		threads.emplace_back([&, index]() {
+			Churn<Allocator> churn{};
+			test::Random random(index + 1);
+			Object window[window_size];
+			for (Object& object : window) {
+				object = churn.Create(random.Below(3), index);
+			}
+			Handoff& outgoing = handoffs[(index + 1) % threadCount];
+			Handoff& incoming = handoffs[index];
+			ready.fetch_add(1);
+			while (!start.load(std::memory_order_acquire)) {
+				std::this_thread::yield();
+			}
+			for (uint32_t i = 0; i < perThread; i++) {
+				uint32_t slot = random.Below(window_size);
+				churn.Destroy(window[slot]);
+				window[slot] = churn.Create(random.Below(3), i);
+				if (threadCount > 1 && i % 4096 == 0 && !outgoing.full.load(std::memory_order_acquire)) {
+					for (Object& object : outgoing.objects) {
+						object = churn.Create(random.Below(3), i);
+					}
+					outgoing.full.store(true, std::memory_order_release);
+				}
+				if (incoming.full.load(std::memory_order_acquire)) {
+					for (Object object : incoming.objects) {
+						churn.Destroy(object);
+					}
+					incoming.full.store(false, std::memory_order_release);
+				}
+			}
+			for (Object object : window) {
+				churn.Destroy(object);
+			}
+		});
+	}
+	while (ready.load() != threadCount) {
+		std::this_thread::yield();
+	}
+	test::Clock::time_point begin = test::Clock::now();
+	start.store(true, std::memory_order_release);
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+	double elapsed = test::ElapsedNanoseconds(begin, test::Clock::now());
+	// whatever is still waiting in a handoff after every thread finished
+	Churn<Allocator> churn{};
+	for (Handoff& handoff : handoffs) {
+		if (handoff.full.load(std::memory_order_acquire)) {
+			for (Object object : handoff.objects) {
+				churn.Destroy(object);
+			}
+		}
+	}
+	return elapsed;
+}
+
+int main() {
+	char name[96];
+	for (uint32_t threadCount : { 1u, 2u, 4u, 8u, 16u }) {
+		std::snprintf(name, sizeof(name), "PoolAllocator churn, %u threads", threadCount);
+		test::Report(name, operation_count, Run<simple::PoolAllocator>(threadCount));
+		std::snprintf(name, sizeof(name), "DynamicAllocator churn, %u threads", threadCount);
+		test::Report(name, operation_count, Run<simple::DynamicAllocator>(threadCount));
+	}
+	return 0;
+}
@@ -0,0 +1,95 @@
+#include "simple_simd.hpp"
+#include "benchmark.hpp"
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+// Every simple::simd kernel through the SSE2 and the AVX2 path (when the cpu has it) against the C library or <algorithm>
+// equivalent, from 16 bytes to 64KB. The inputs only match at their very end, so every call scans the whole input.
+
+namespace simd = simple::simd;
+
+constexpr size_t lengths[] = { 16, 64, 256, 4096, 65536 };
+constexpr uint64_t bytes_per_run = 1 << 26;
+
+template<typename Func>
+static void Run(const char* kernel, const char* variant, size_t length, Func&& func) {
+	uint64_t iterations = bytes_per_run / (length + 16);
+	double elapsed = test::Measure(5, [&]() {
+		uint64_t sum = 0;
+		for (uint64_t i = 0; i < iterations; i++) {
+			sum += func(test::Opaque(length));
+		}
+		test::Consume(sum);
+	});
+	char name[96];
+	std::snprintf(name, sizeof(name), "%s %zu bytes (%s)", kernel, length, variant);
+	test::Report(name, iterations, elapsed);
+}
+
+// runs the kernel through the dispatcher once per available path and once as the baseline
+template<typename Kernel, typename Baseline>
+static void Compare(const char* kernel, const char* baselineName, size_t length, Kernel&& simdKernel, Baseline&& baseline) {
+	bool avx2 = simd::cpu_has_avx2;
+	simd::cpu_has_avx2 = false;
+	Run(kernel, "SSE2", length, simdKernel);
+	if (avx2) {
+		simd::cpu_has_avx2 = true;
+		Run(kernel, "AVX2", length, simdKernel);
+	}
+	Run(kernel, baselineName, length, baseline);
+}
+
+int main() {
+	constexpr size_t max_length = 65536;
+	std::vector<char> a(max_length + 1);
+	std::vector<char> b(max_length + 1);
+	std::vector<uint32_t> values(max_length);
+	const char needle[] = "needle!!";
+	constexpr size_t needle_length = sizeof(needle) - 1;
+	// every kernel below plants its match at the end of the inputs, each one gets fresh ones
+	auto fill = [&]() {
+		for (size_t i = 0; i < max_length; i++) {
+			a[i] = b[i] = static_cast<char>('a' + i % 23);
+			values[i] = static_cast<uint32_t>(i % 1000);
+		}
+	};
+	for (size_t length : lengths) {
+		char* string = a.data();
+		fill();
+		string[length] = 0;
+		Compare("Length", "strlen", length,
+			[&](size_t) { return simd::Length(string); },
+			[&](size_t) { return std::strlen(string); });
+		fill();
+
+		Compare("Equal", "memcmp", length,
+			[&](size_t n) { return (size_t)simd::Equal(a.data(), b.data(), n); },
+			[&](size_t n) { return (size_t)!std::memcmp(a.data(), b.data(), n); });
+
+		b[length - 1] = '#';
+		Compare("Mismatch", "std::mismatch", length,
+			[&](size_t n) { return simd::Mismatch(a.data(), b.data(), n); },
+			[&](size_t n) { return (size_t)(std::mismatch(a.data(), a.data() + n, b.data()).first - a.data()); });
+		fill();
+
+		string[length - 1] = '#';
+		Compare("FindChar", "memchr", length,
+			[&](size_t n) { return simd::FindChar(string, n, '#'); },
+			[&](size_t n) { return (size_t)(static_cast<const char*>(std::memchr(string, '#', n)) - string); });
+		fill();
+
+		std::memcpy(string + length - needle_length, needle, needle_length);
+		Compare("FindString", "std::string_view::find", length,
+			[&](size_t n) { return simd::FindString(string, n, needle, needle_length); },
+			[&](size_t n) { return std::string_view(string, n).find(std::string_view(needle, needle_length)); });
+
+		uint32_t* data = values.data();
+		data[length / 4 - 1] = UINT32_MAX;
+		Compare("FindValue<uint32_t>", "std::find", length,
+			[&](size_t n) { return simd::FindValue<uint32_t>(data, n / 4, UINT32_MAX); },
+			[&](size_t n) { return (size_t)(std::find(data, data + n / 4, UINT32_MAX) - data); });
+	}
+	return 0;
+}
@@ -0,0 +1,313 @@
+#include "simple_simd.hpp"
+#include "test.hpp"
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <unistd.h>
+#define SIMPLE_TEST_GUARD_PAGE
+#endif
+
+// Every simple::simd kernel against a plain scalar loop, for every length up to max_length (plus a few long ones for the
+// unrolled loops) at every alignment offset up to max_offset, once through the SSE2 kernels and once through the AVX2
+// ones when the cpu has them. The inputs also get placed right in front of an unmapped page, so a kernel that reads
+// past the end of its input crashes the test instead of passing by luck.
+
+namespace simd = simple::simd;
+
+constexpr size_t max_length = 100;
+constexpr size_t max_offset = 32;
+constexpr size_t long_lengths[] = { 127, 128, 129, 255, 256, 257, 1000, 4000 };
+constexpr size_t buffer_size = 4096 + 2 * max_offset;
+
+static std::vector<size_t> Lengths() {
+	std::vector<size_t> lengths{};
+	for (size_t length = 0; length <= max_length; length++) {
+		lengths.push_back(length);
+	}
+	lengths.insert(lengths.end(), std::begin(long_lengths), std::end(long_lengths));
+	return lengths;
+}
+
+// positions to modify in an input of length, all of them for short inputs and the ones around the ends and a sample of
+// the middle for long ones
+static bool Probe(size_t position, size_t length) {
+	return length <= max_length || position < 64 || position + 64 > length || position % 37 == 0;
+}
+
+// a character for every position that is never 0 and covers the bytes with the high bit set
+static char Filler(size_t position) {
+	return static_cast<char>(1 + (position * 31) % 255);
+}
+
+static size_t ScalarMismatch(const char* a, const char* b, size_t length) {
+	size_t i = 0;
+	while (i < length && a[i] == b[i]) {
+		i++;
+	}
+	return i;
+}
+
+template<typename T>
+static size_t ScalarFindValue(const T* data, size_t count, T value) {
+	for (size_t i = 0; i < count; i++) {
+		if (data[i] == value) {
+			return i;
+		}
+	}
+	return simd::npos;
+}
+
+#ifdef SIMPLE_TEST_GUARD_PAGE
+
+// one readable page followed by an unmapped one, End() - length is an input that ends right at the boundary
+struct GuardedPage {
+
+	char* memory;
+	size_t pageSize;
+
+	inline GuardedPage() noexcept : pageSize(static_cast<size_t>(sysconf(_SC_PAGESIZE))) {
+		void* mapped = mmap(nullptr, pageSize * 2, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		SIMPLE_CHECK(mapped != MAP_FAILED);
+		memory = static_cast<char*>(mapped);
+		SIMPLE_CHECK(mprotect(memory + pageSize, pageSize, PROT_NONE) == 0);
+	}
+
+	inline char* End() const noexcept {
+		return memory + pageSize;
+	}
+
+	inline ~GuardedPage() {
+		munmap(memory, pageSize * 2);
+	}
+};
+
+static void TestGuarded() {
+	GuardedPage pageA{};
+	GuardedPage pageB{};
+	for (size_t length = 0; length <= max_length; length++) {
+		char* a = pageA.End() - length;
+		char* b = pageB.End() - length;
+		for (size_t i = 0; i < length; i++) {
+			a[i] = b[i] = Filler(i);
+		}
+		SIMPLE_CHECK(simd::Equal(a, b, length));
+		SIMPLE_CHECK(simd::Mismatch(a, b, length) == length);
+		SIMPLE_CHECK(simd::FindChar(a, length, 0) == simd::npos);
+		if (length) {
+			// the terminator is the last readable byte
+			a[length - 1] = 0;
+			SIMPLE_CHECK(simd::Length(a) == length - 1);
+			const char needle[] = { Filler(0), Filler(1), Filler(2) };
+			size_t needleLength = length < 3 ? length : 3;
+			SIMPLE_CHECK(simd::FindString(b, length, needle, needleLength) == 0);
+			SIMPLE_CHECK(simd::FindString(b, length, "\0\0", 2) == simd::npos);
+		}
+		uint32_t* values = reinterpret_cast<uint32_t*>(pageA.End()) - length;
+		for (size_t i = 0; i < length; i++) {
+			values[i] = static_cast<uint32_t>(i);
+		}
+		SIMPLE_CHECK(simd::FindValue<uint32_t>(values, length, UINT32_MAX) == simd::npos);
+	}
+}
+
+#endif
+
+static void TestLength() {
+	alignas(64) char buffer[buffer_size];
+	for (size_t offset = 0; offset < max_offset; offset++) {
+		for (size_t length : Lengths()) {
+			char* string = buffer + offset;
+			for (size_t i = 0; i < length; i++) {
+				string[i] = Filler(i);
+			}
+			string[length] = 0;
+			// a second terminator right behind the first one must not matter
+			string[length + 1] = 0;
+			SIMPLE_CHECK(simd::Length(string) == length);
+		}
+	}
+}
+
+static void TestEqualAndMismatch() {
+	alignas(64) char bufferA[buffer_size];
+	alignas(64) char bufferB[buffer_size];
+	for (size_t offset = 0; offset < max_offset; offset++) {
+		// the two inputs are misaligned differently from each other
+		char* a = bufferA + offset;
+		char* b = bufferB + (offset * 7 + 3) % max_offset;
+		for (size_t length : Lengths()) {
+			for (size_t i = 0; i < length; i++) {
+				a[i] = b[i] = Filler(i);
+			}
+			// differences right behind the inputs must not be seen
+			a[length] = 'a';
+			b[length] = 'b';
+			SIMPLE_CHECK(simd::Equal(a, b, length));
+			SIMPLE_CHECK(simd::Mismatch(a, b, length) == length);
+			for (size_t position = 0; position < length; position++) {
+				if (!Probe(position, length)) {
+					continue;
+				}
+				b[position] ^= 0x40;
+				SIMPLE_CHECK(!simd::Equal(a, b, length));
+				SIMPLE_CHECK(simd::Mismatch(a, b, length) == position);
+				SIMPLE_CHECK(ScalarMismatch(a, b, length) == position);
+				// a second difference further on doesn't change the first one
+				if (position + 5 < length) {
+					b[position + 5] ^= 0x01;
+					SIMPLE_CHECK(simd::Mismatch(a, b, length) == position);
+					b[position + 5] ^= 0x01;
+				}
+				b[position] ^= 0x40;
+			}
+		}
+	}
+}
+
+static void TestFindChar() {
+	alignas(64) char buffer[buffer_size];
+	for (char c : { 'z', static_cast<char>(0xf0), '\0' }) {
+		for (size_t offset = 0; offset < max_offset; offset++) {
+			char* string = buffer + offset;
+			for (size_t length : Lengths()) {
+				for (size_t i = 0; i < length; i++) {
+					string[i] = Filler(i) == c ? 'a' : Filler(i);
+				}
+				// a match right behind the input must not be found
+				string[length] = c;
+				SIMPLE_CHECK(simd::FindChar(string, length, c) == simd::npos);
+				for (size_t position = 0; position < length; position++) {
+					if (!Probe(position, length)) {
+						continue;
+					}
+					char old = string[position];
+					string[position] = c;
+					SIMPLE_CHECK(simd::FindChar(string, length, c) == position);
+					// the first of two matches wins
+					if (position + 17 < length) {
+						char later = string[position + 17];
+						string[position + 17] = c;
+						SIMPLE_CHECK(simd::FindChar(string, length, c) == position);
+						string[position + 17] = later;
+					}
+					string[position] = old;
+				}
+			}
+		}
+	}
+}
+
+static void TestFindString() {
+	alignas(64) char buffer[buffer_size];
+	test::Random random(5);
+	const size_t needleLengths[] = { 0, 1, 2, 3, 4, 7, 15, 16, 17, 31, 32, 33, 40 };
+	for (size_t offset = 0; offset < max_offset; offset++) {
+		char* haystack = buffer + offset;
+		for (size_t length : Lengths()) {
+			for (size_t needleLength : needleLengths) {
+				char needle[64];
+				// from a two letter alphabet, so there are lots of candidates that match the first and last character
+				for (size_t i = 0; i < needleLength; i++) {
+					needle[i] = 'a' + random.Below(2);
+				}
+				for (uint32_t round = 0; round < 3; round++) {
+					for (size_t i = 0; i < length; i++) {
+						haystack[i] = 'a' + random.Below(2);
+					}
+					std::string_view view(haystack, length);
+					SIMPLE_CHECK(simd::FindString(haystack, length, needle, needleLength) == view.find(std::string_view(needle, needleLength)));
+				}
+				if (!needleLength || needleLength > length) {
+					continue;
+				}
+				// the needle at every position of a haystack that can't match anywhere else
+				for (size_t i = 0; i < length; i++) {
+					haystack[i] = 'c';
+				}
+				// a match that only starts inside the input but ends behind it must not be found
+				std::memcpy(haystack + length - needleLength + 1, needle, needleLength);
+				SIMPLE_CHECK(simd::FindString(haystack, length, needle, needleLength) == simd::npos);
+				for (size_t position = 0; position + needleLength <= length; position++) {
+					if (!Probe(position, length)) {
+						continue;
+					}
+					for (size_t i = 0; i < length + needleLength; i++) {
+						haystack[i] = 'c';
+					}
+					std::memcpy(haystack + position, needle, needleLength);
+					SIMPLE_CHECK(simd::FindString(haystack, length, needle, needleLength) == position);
+				}
+			}
+		}
+	}
+}
+
+// values that share bytes or one 32 bit half with the needle, which the SSE2 64 bit compare has to tell apart
+template<typename T>
+static T Neighbour(T needle, size_t position) {
+	if constexpr (sizeof(T) == 8) {
+		return needle ^ (position % 2 ? 0x0000000100000000ull : 0x0000000000000001ull) * (1 + position % 7);
+	}
+	else {
+		return static_cast<T>(needle ^ static_cast<T>(1 + position % 7));
+	}
+}
+
+template<typename T>
+static void TestFindValue() {
+	alignas(64) T buffer[max_offset + 4000 + 1];
+	for (T needle : { static_cast<T>(0), static_cast<T>(-1), static_cast<T>(0x5a5a5a5a5a5a5a5aull) }) {
+		for (size_t offset = 0; offset < max_offset; offset++) {
+			T* data = buffer + offset;
+			for (size_t count : Lengths()) {
+				for (size_t i = 0; i < count; i++) {
+					data[i] = Neighbour(needle, i);
+				}
+				data[count] = needle;
+				SIMPLE_CHECK(simd::FindValue(data, count, needle) == simd::npos);
+				for (size_t position = 0; position < count; position++) {
+					if (!Probe(position, count)) {
+						continue;
+					}
+					data[position] = needle;
+					SIMPLE_CHECK(simd::FindValue(data, count, needle) == position);
+					SIMPLE_CHECK(ScalarFindValue(data, count, needle) == position);
+					data[position] = Neighbour(needle, position);
+				}
+			}
+		}
+	}
+}
+
+static void RunAll() {
+	TestLength();
+	TestEqualAndMismatch();
+	TestFindChar();
+	TestFindString();
+	TestFindValue<int8_t>();
+	TestFindValue<uint8_t>();
+	TestFindValue<int16_t>();
+	TestFindValue<uint32_t>();
+	TestFindValue<int64_t>();
+	TestFindValue<uint64_t>();
+#ifdef SIMPLE_TEST_GUARD_PAGE
+	TestGuarded();
+#endif
+}
+
+int main() {
+	bool avx2 = simd::DetectAvx2();
+	simd::cpu_has_avx2 = false;
+	RunAll();
+	if (avx2) {
+		simd::cpu_has_avx2 = true;
+		RunAll();
+	}
+	else {
+		std::printf("the cpu doesn't support AVX2, only the SSE2 kernels were tested\n");
+	}
+	return 0;
+}
@@ -0,0 +1,80 @@
+#include "simple_small_dynamic_array.hpp"
+#include "test.hpp"
+#include <string>
+
+// Copy assignment reuses storage that's large enough and Swap works for every inline/heap combination.
+
+static int allocation_count = 0;
+
+template<typename T>
+struct CountingAllocator : simple::DynamicAllocator<T> {
+
+	inline T* allocate(size_t size) {
+		allocation_count++;
+		return simple::DynamicAllocator<T>::allocate(size);
+	}
+};
+
+template<typename T>
+struct simple::TriviallyRelocatable<CountingAllocator<T>> {
+	static constexpr inline bool value = true;
+};
+
+using Strings = simple::SmallDynamicArray<std::string, 4>;
+
+static Strings Make(const char* prefix, int count) {
+	Strings result{};
+	for (int i = 0; i < count; i++) {
+		result.PushBack(prefix + std::to_string(i));
+	}
+	return result;
+}
+
+static bool Holds(const Strings& array, const char* prefix, int count) {
+	if (array.Size() != (uint32_t)count) {
+		return false;
+	}
+	for (int i = 0; i < count; i++) {
+		if (array[i] != prefix + std::to_string(i)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+int main() {
+	{
+		simple::SmallDynamicArray<std::string, 2, CountingAllocator<std::string>> source{}, large{}, small{};
+		for (int i = 0; i < 10; i++) {
+			source.PushBack(std::to_string(i));
+		}
+		for (int i = 0; i < 16; i++) {
+			large.PushBack("x");
+		}
+		int before = allocation_count;
+		large = source;
+		SIMPLE_CHECK(allocation_count == before);
+		SIMPLE_CHECK(large.Size() == 10 && large[9] == "9");
+		small.PushBack("y");
+		small = source;
+		SIMPLE_CHECK(small.Size() == 10 && small[0] == "0" && small[9] == "9");
+		small = small;
+		SIMPLE_CHECK(small.Size() == 10);
+	}
+	const int counts[] = { 0, 1, 4, 5, 9 };
+	for (int a : counts) {
+		for (int b : counts) {
+			Strings first = Make("a", a);
+			Strings second = Make("b", b);
+			first.Swap(second);
+			SIMPLE_CHECK(Holds(first, "b", b) && Holds(second, "a", a));
+			SIMPLE_CHECK(first.IsInline() == (b <= 4) && second.IsInline() == (a <= 4));
+			first.PushBack("b" + std::to_string(b));
+			SIMPLE_CHECK(Holds(first, "b", b + 1));
+		}
+	}
+	Strings self = Make("s", 6);
+	self.Swap(self);
+	SIMPLE_CHECK(Holds(self, "s", 6));
+	return 0;
+}
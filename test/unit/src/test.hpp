@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+
+// Checks for the unit tests, a failed check prints where it failed and exits with 1 so ctest reports the test as failed.
+// Unlike assert it stays active in release builds, which is where the SIMD and lock-free paths matter most.
+#define SIMPLE_CHECK(condition) \
+	do { \
+		if (!(condition)) { \
+			std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+			std::exit(1); \
+		} \
+	} while (0)
+
+namespace test {
+
+	// xorshift64*, deterministic so a failing run can be reproduced
+	struct Random {
+
+		unsigned long long state;
+
+		inline explicit Random(unsigned long long seed = 0x9e3779b97f4a7c15ull) noexcept : state(seed ? seed : 1) {}
+
+		inline unsigned long long Next() noexcept {
+			state ^= state >> 12;
+			state ^= state << 25;
+			state ^= state >> 27;
+			return state * 0x2545f4914f6cdd1dull;
+		}
+
+		// in [0, bound)
+		inline unsigned long long Below(unsigned long long bound) noexcept {
+			return Next() % bound;
+		}
+	};
+}